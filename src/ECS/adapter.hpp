@@ -34,11 +34,32 @@
 #include <span>
 #include <type_traits>
 
+// Swiss tables match 16 control bytes at once, define ECS_HASHTABLE_NO_SIMD to always use the portable implementation
+#ifndef ECS_HASHTABLE_NO_SIMD
+	#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+		#include <emmintrin.h>
+		#define ECS_HASHTABLE_SSE2
+	#elif defined(__aarch64__) || defined(_M_ARM64)
+		#include <arm_neon.h>
+		#define ECS_HASHTABLE_NEON
+	#endif
+#endif
+
 namespace ecs {
+	/**
+	* @brief Gets a component storage viewed through an adapter
+	*
+	* @tparam T The adapter (such as typed::component_storage or hashtable::component_storage)
+	* @return The adapted storage (which is created if it doesn't exist yet)
+	* @warning Adapters access their elements as a single array, so a paged storage is converted to the contiguous layout the first time it is adapted.
+	*	Every element is moved (invalidating references to them), and the storage stays contiguous afterwards (so snapshots copy all of its elements up front, rather than a page at a time).
+	*	Call component_storage::set_layout beforehand to choose when the conversion happens.
+	*/
 	template<typename T>
 	optional_reference<T> get_adapted_component_storage(scene& scene) {
 		auto res = scene.get_storage<typename T::component_type>();
 		if(!res) return {};
+		res->set_layout(scene::component_storage::layout::contiguous);
 		return {*(T*)&(*res)};
 	}
 
@@ -58,13 +79,15 @@ namespace ecs {
 			void sort(struct scene& scene, const F& comparator) { Base::sort<Tcomponent, F, with_entities, Unique>(scene, comparator); }
 			void sort_by_value(struct scene& scene) { Base::sort_by_value<Tcomponent, Unique>(scene); }
 			void sort_monotonic(struct scene& scene) { Base::sort_monotonic<Tcomponent, Unique>(scene); }
+			template<typename KeyFn>
+			void sort_by_key(struct scene& scene, const KeyFn& key) { Base::sort_by_key<Tcomponent, Unique>(scene, key); }
 			bool swap(size_t a, std::optional<size_t> b = {}) { return Base::swap<Tcomponent>(a, b); }
 			bool swap(struct scene& scene, size_t a, std::optional<size_t> b = {}, bool swap_if_one_elementless = false) {
 				return Base::swap<Tcomponent, Unique>(scene, a, b, swap_if_one_elementless);
 			}
 
-			Tcomponent* data() { return (Tcomponent*)Base::data.data(); }
-			const Tcomponent* data() const { return (const Tcomponent*)Base::data.data(); }
+			Tcomponent* data() { assert(Base::is_contiguous()); return (Tcomponent*)Base::data.data(); }
+			const Tcomponent* data() const { assert(Base::is_contiguous()); return (const Tcomponent*)Base::data.data(); }
 			std::span<Tcomponent> span() { return {data(), Base::size()}; }
 			std::span<const Tcomponent> span() const { return {data(), Base::size()}; }
 		};
@@ -107,6 +130,14 @@ namespace ecs {
 					if constexpr(requires(Tvalue t){Tvalue::swap_entities(t, eA, eB);})
 						Tvalue::swap_entities(e.value, eA, eB);
 				}
+				static inline void remap_entities(hash_entry& e, std::span<const ecs::entity> remap)
+					requires(ecs::detail::references_entities<Tkey> || ecs::detail::references_entities<Tvalue>)
+				{
+					if constexpr(ecs::detail::references_entities<Tkey>)
+						ecs::remap_references(e.key, remap);
+					if constexpr(ecs::detail::references_entities<Tvalue>)
+						ecs::remap_references(e.value, remap);
+				}
 			};
 			template<typename Tkey>
 			struct hash_entry<Tkey, void> : public hash_entry_base {
@@ -117,8 +148,59 @@ namespace ecs {
 				{
 					Tkey::swap_entities(e.key, eA, eB);
 				}
+				static inline void remap_entities(hash_entry& e, std::span<const ecs::entity> remap)
+					requires(ecs::detail::references_entities<Tkey>)
+				{
+					ecs::remap_references(e.key, remap);
+				}
 			};
 
+			/**
+			* @brief Hashes a key, forwarding the context (such as the owning module) if the hasher accepts it
+			*/
+			template<typename Hash, typename Tkey, typename... Context>
+			inline size_t hash_key(const Tkey& key, const Context&... context) {
+				if constexpr(requires(Hash hash) { hash(key, context...); })
+					return Hash{}(key, context...);
+				else return Hash{}(key);
+			}
+
+			/**
+			* @brief Compares two keys, using their equals member (which is given the context) if they provide one
+			*/
+			template<typename Tkey, typename... Context>
+			inline bool keys_equal(const Tkey& a, const Tkey& b, const Context&... context) {
+				if constexpr(requires { { a.equals(b, context...) } -> std::convertible_to<bool>; })
+					return a.equals(b, context...);
+				else return a == b;
+			}
+
+			/**
+			* @brief Gives an unowned cell to an entity, updating the storage's sparse index and the scene's signatures (no cells move)
+			*/
+			template<typename Tcomponent, size_t Unique>
+			inline void claim_cell(scene& scene, typed::component_storage<Tcomponent, Unique>& storage, size_t index, entity e) {
+				storage.entities[index] = e;
+				storage.set_index(e, index);
+				++storage.modifications;
+				storage.data()[index].entity = e;
+				scene.update_signature(e, get_global_component_id<Tcomponent, Unique>(), true);
+			}
+
+			/**
+			* @brief Takes a cell away from its entity, leaving it in place as an unowned cell (no cells move)
+			*/
+			template<typename Tcomponent, size_t Unique>
+			inline void release_cell(scene& scene, typed::component_storage<Tcomponent, Unique>& storage, size_t index) {
+				entity e = storage.entities[index];
+				if(e == invalid_entity) return;
+				storage.entities[index] = invalid_entity;
+				storage.set_index(e, scene::component_storage::invalid);
+				++storage.modifications;
+				storage.data()[index].entity = invalid_entity;
+				scene.update_signature(e, get_global_component_id<Tcomponent, Unique>(), false);
+			}
+
 			template<typename Tkey, typename Tvalue>
 			struct hash_entry_with_hash: public hash_entry<Tkey, Tvalue> {
 				size_t hash;
@@ -129,6 +211,11 @@ namespace ecs {
 				{
 					Entry::swap_entities(e, eA, eB);
 				}
+				static inline void remap_entities(hash_entry_with_hash& e, std::span<const ecs::entity> remap)
+					requires(ecs::detail::references_entities<Entry>)
+				{
+					Entry::remap_entities(e, remap);
+				}
 			};
 		}
 
@@ -143,8 +230,20 @@ namespace ecs {
 				if constexpr(requires(Entry e){Entry::swap_entities(e, eA, eB);})
 					Entry::swap_entities(w.value, eA, eB);
 			}
+			static inline void remap_entities(component_wrapper& w, std::span<const ecs::entity> remap) {
+				Base::remap_entities(w, remap);
+				if constexpr(ecs::detail::references_entities<Entry>)
+					Entry::remap_entities(w.value, remap);
+			}
 		};
 
+	}
+
+	// Hashtable cells are found by their position, compacting them would lose track of where the keys are
+	template<typename Tkey, typename Tvalue>
+	struct is_positional<hashtable::component_wrapper<Tkey, Tvalue>> : public std::true_type {};
+
+	namespace hashtable {
 		/*constexpr*/ size_t one_over_one_minus(float factor)
 #ifdef ECS_IMPLEMENTATION
 		{
@@ -182,13 +281,20 @@ namespace ecs {
 			static constexpr float maxLoadFactor = 1 - 1.0 / OneOverOneMinusMaxLoadFactor;
 			static constexpr float store_hash = is_costly_to_compare_v<key_type>;
 
-			size_t current_size() const {
+			// Number of cells the table hashes into (cells past it have been added since the table was last rehashed)
+			inline size_t buckets() const { return Base::adapter.capacity; }
+
+			size_t count_occupied() const {
 				size_t size = 0;
 				for(auto& e: Base::span())
-					if(e.is_occupied())
+					if(e->is_occupied())
 						++size;
 				return size;
 			}
+			inline size_t current_size() const {
+				if(!Base::adapter.dirty) return Base::adapter.count; // Tracked as cells are inserted and removed
+				return count_occupied();
+			}
 
 			// const key_type& key(const kv_pair& key_value) {
 			// 	if constexpr(has_value_type)
@@ -197,19 +303,23 @@ namespace ecs {
 			// }
 
 			inline float load_factor() const {
-				return float(current_size()) / Base::size();
+				if(buckets() == 0) return 0;
+				return float(current_size()) / buckets();
 			}
 
-			inline size_t hash(const key_type& key) const {
-				return Hash{}(key) % Base::size();
+			template<typename... Context>
+			inline size_t hash(const key_type& key, const Context&... context) const {
+				return detail::hash_key<Hash>(key, context...) % buckets();
 			}
 
-			std::optional<size_t> find_position(const key_type& key) const {
-				size_t hash = this->hash(key);
+			template<typename... Context>
+			std::optional<size_t> find_position(const key_type& key, const Context&... context) const {
+				if(buckets() == 0) return {};
+				size_t hash = this->hash(key, context...);
 				for(size_t i = 0; i < NeighborhoodSize; ++i) {
-					size_t probe = (hash + i) % Base::size();
+					size_t probe = (hash + i) % buckets();
 					if constexpr(store_hash) if(!Base::data()[probe]->is_occupied() || Base::data()[probe]->hash != hash) continue;
-					if(Base::data()[probe]->is_occupied() && Base::data()[probe]->key == key)
+					if(Base::data()[probe]->is_occupied() && detail::keys_equal(Base::data()[probe]->key, key, context...))
 						return probe;
 				}
 				return {};
@@ -217,7 +327,7 @@ namespace ecs {
 
 			std::optional<size_t> find_empty_spot(size_t start) const {
 				for(size_t i = 0; i < NeighborhoodSize; ++i) {
-					size_t probe = (start + i) % Base::size();
+					size_t probe = (start + i) % buckets();
 					if(!Base::data()[probe]->is_occupied())
 						return probe;
 				}
@@ -226,58 +336,95 @@ namespace ecs {
 
 			std::optional<size_t> find_nearest_neighbor(size_t start) const {
 				for(size_t j = 0; j < NeighborhoodSize; ++j) {
-					size_t probe = (start + j) % Base::size();
+					size_t probe = (start + j) % buckets();
 					if((Base::data()[start]->hopInfo & (1 << j)) && !Base::data()[probe]->is_occupied())
 						return probe;
 				}
 				return {};
 			}
 
+			inline size_t distance(size_t home, size_t index) const { return index >= home ? index - home : buckets() - (home - index); }
+
+			// Moves an occupied cell into an empty one (the neighborhood information stays with the positions, not the cells)
+			bool move_cell(scene& scene, size_t from, size_t to) {
+				size_t hopInfoFrom = Base::data()[from]->hopInfo, hopInfoTo = Base::data()[to]->hopInfo;
+				if(!Base::swap(scene, to, from, true)) return false;
+				Base::data()[from]->hopInfo = hopInfoFrom;
+				Base::data()[from]->set_occupied(false);
+				Base::data()[to]->hopInfo = hopInfoTo;
+				Base::data()[to]->set_occupied(true);
+				return true;
+			}
+
+			// Finds an empty cell in home's neighborhood, hopping closer cells towards their own homes to make room if needed
+			std::optional<size_t> make_room(scene& scene, size_t home) {
+				size_t table = buckets(), empty = 0, dist = 0;
+				for(; dist < table; ++dist)
+					if(empty = (home + dist) % table; !Base::data()[empty]->is_occupied()) break;
+				if(dist == table) return {}; // Full
+
+				while(dist >= NeighborhoodSize) {
+					bool moved = false;
+					// Find the furthest back cell whose neighborhood includes the empty cell, and move its closest member into the empty cell
+					for(size_t back = NeighborhoodSize - 1; back > 0 && !moved; --back) {
+						size_t candidate = (empty + table - back) % table;
+						for(size_t j = 0; j < back; ++j)
+							if(Base::data()[candidate]->hopInfo & (1 << j)) {
+								size_t from = (candidate + j) % table;
+								if(!move_cell(scene, from, empty)) return {};
+								Base::data()[candidate]->hopInfo &= ~(1 << j);
+								Base::data()[candidate]->hopInfo |= (1 << back);
+								empty = from;
+								dist -= back - j;
+								moved = true;
+								break;
+							}
+					}
+					if(!moved) return {}; // Nothing can move out of the way, the table needs to grow
+				}
+				return empty;
+			}
+
+			// Removes the cell from the table (and its entity) without moving any other cells
+			template<typename... Context>
+			void erase_at(scene& scene, size_t index, const Context&... context) {
+				if(Base::data()[index]->is_occupied()) {
+					if(index < buckets()) {
+						size_t home = this->hash(Base::data()[index]->key, context...);
+						Base::data()[home]->hopInfo &= ~(1 << distance(home, index));
+					}
+					Base::data()[index]->set_occupied(false);
+					--Base::adapter.count;
+				}
+				detail::release_cell(scene, *this, index);
+			}
+
 			inline bool is_in_neighborhood(size_t start, size_t needle) const {
-				if(NeighborhoodSize > Base::size()) return true;
-				size_t end = (start + NeighborhoodSize) % Base::size();
+				if(NeighborhoodSize > buckets()) return true;
+				size_t end = (start + NeighborhoodSize) % buckets();
 				if(start <= end)
-					return needle >= start && needle <= end; // TODO: should be < instead?
+					return needle >= start && needle < end; // Lookups only probe NeighborhoodSize cells, so the end is exclusive
 				else // The neighborhood range wraps around the end of the table
-					return needle >= start || needle <= end;
+					return needle >= start || needle < end;
 			}
 
-			// bool insert_impl(scene& scene, const kv_pair& key_value, size_t retries = 0) {
-			// 	size_t hash = this->hash(key(key_value));
-
-			// 	auto emptyIndex = find_empty_spot(hash);
-			// 	if(!emptyIndex) {
-			// 		if(!resize_and_rehash(scene)) return false;
-			// 		if(retries == 5) return false;
-			// 		return insert_impl(scene, key_value, retries + 1);
-			// 	}
-
-			// 	if constexpr(has_value_type) {
-			// 		Base::data()[*emptyIndex]->key = key_value.first;
-			// 		Base::data()[*emptyIndex]->value = key_value.second;
-			// 	} else
-			// 		Base::data()[*emptyIndex].key = key_value;
-			// 	Base::data()[*emptyIndex]->set_occupied(true);
-			// 	if constexpr(store_hash) Base::data()[*emptyIndex].hash = hash;
-
-			// 	size_t distance = *emptyIndex > hash ? *emptyIndex - hash : Base::size() - (hash - *emptyIndex);
-			// 	Base::data()[hash]->hopInfo |= (1 << distance);
-			// 	return true;
-			// }
-
-			inline bool resize_and_rehash(scene& scene, size_t retries = 0) {
-				auto& raw = scene::component_storage::data;
-				raw.resize(std::max(raw.size() * 2, scene::component_storage::element_size));
+			template<typename... Context>
+			inline bool resize_and_rehash(scene& scene, size_t retries, const Context&... context) {
+				// Double the table (allocating constructs the new cells and gives them invalid back-map entries)
+				if(!Base::allocate(std::max<size_t>(Base::size(), 1))) return false;
 				// Make sure all of the new cells are initialized with invalid entities
 				for(size_t i = 0; i < Base::size(); ++i)
 					if(!Base::data()[i]->is_occupied())
 						Base::data()[i].entity = invalid_entity;
-				return rehash(scene, retries, true);
+				return rehash_impl(scene, retries, true, context...);
 			}
 
-			bool rehash(scene& scene, size_t retries, bool resized = false) {
+			template<typename... Context>
+			bool rehash_impl(scene& scene, size_t retries, bool resized, const Context&... context) {
 				// Clear the neighborhood information
 				size_t size = Base::size(), half = size / 2;
+				Base::adapter.capacity = Base::adapter.organized = size; // Every cell becomes part of the table
+				Base::metadata.clear();
 				for(size_t i = 0; i < size; ++i) {
 					bool occupied = Base::data()[i]->is_occupied();
 					Base::data()[i]->hopInfo = 0;
@@ -291,12 +438,12 @@ namespace ecs {
 				// Traverse through the old table and "reinsert" elements into the table
 				for(size_t i = 0; i < size; ++i)
 					if(Base::data()[i]->is_occupied()) {
-						size_t hash = this->hash(Base::data()[i]->key);
+						size_t hash = this->hash(Base::data()[i]->key, context...);
 
 						// If the value is already in the correct neighborhood... no need to move around just mark as present
 						if(is_in_neighborhood(hash, i)) {
 							if constexpr(store_hash) Base::data()[i]->hash = hash;
-							size_t distance = i > hash ? i - hash : size - (hash - i);
+							size_t distance = i >= hash ? i - hash : size - (hash - i);
 							Base::data()[hash]->hopInfo |= (1 << distance);
 							continue;
 						}
@@ -305,7 +452,7 @@ namespace ecs {
 						auto emptyIndex = find_empty_spot(hash);
 						if(!emptyIndex) {
 							if(retries >= MaxRetries) return false;
-							return resize_and_rehash(scene, retries + 1); // TODO: We can probably use a better strategy than "resize and try again"
+							return resize_and_rehash(scene, retries + 1, context...); // TODO: We can probably use a better strategy than "resize and try again"
 						}
 
 						// Move the element to its new position in the table
@@ -317,63 +464,464 @@ namespace ecs {
 						Base::data()[*emptyIndex]->set_occupied(true);
 
 						// Mark it as present in the element it hashes to
-						size_t distance = *emptyIndex > hash ? *emptyIndex - hash : size - (hash - *emptyIndex);
+						size_t distance = *emptyIndex >= hash ? *emptyIndex - hash : size - (hash - *emptyIndex);
 						Base::data()[hash]->hopInfo |= (1 << distance);
 					}
 
+				Base::adapter.count = count_occupied();
+				Base::adapter.dirty = false;
+				return true;
+			}
+
+			// Inserts the cells added since the last rehash into the table, only falling back to a full rehash if one doesn't fit
+			template<typename... Context>
+			bool insert_added(scene& scene, const Context&... context) {
+				size_t table = buckets();
+				for(size_t i = Base::adapter.organized; i < Base::size(); ++i) {
+					if(!Base::data()[i]->is_occupied()) continue;
+					if(Base::adapter.count + 1 > table * maxLoadFactor) return resize_and_rehash(scene, 0, context...);
+
+					size_t hash = this->hash(Base::data()[i]->key, context...);
+					auto emptyIndex = make_room(scene, hash);
+					if(!emptyIndex) return rehash_impl(scene, 0, false, context...);
+
+					// Swap the new cell with the empty one (the empty cell is left outside the table, to be reclaimed by the next full rehash)
+					if(!move_cell(scene, i, *emptyIndex)) return false;
+					Base::data()[i]->hopInfo = 0;
+					if constexpr(store_hash) Base::data()[*emptyIndex]->hash = hash;
+					Base::data()[hash]->hopInfo |= (1 << distance(hash, *emptyIndex));
+					++Base::adapter.count;
+				}
+				Base::adapter.organized = Base::size();
+				Base::adapter.dirty = false; // Our own swaps don't disturb the table (or the cells outside of it)
 				return true;
 			}
 
 		public:
 			using component_type = component_t;
 
-			inline bool rehash(scene& scene) {
-				return rehash(scene, 0);
+			/**
+			* @brief Brings the hashtable's neighborhood information up to date (moving elements as needed)
+			*
+			* @param scene The scene the hashtable belongs to
+			* @param context Extra state (such as the owning module) passed along to the hasher and key comparisons
+			* @note Free if nothing has changed, and only inserts the new cells if cells have only been added since the last rehash.
+			*	Cells which were moved, removed, or renumbered cause the whole table to be rebuilt
+			*/
+			template<typename... Context>
+			inline bool rehash(scene& scene, const Context&... context) {
+				if(Base::adapter.dirty || buckets() == 0 || !Base::metadata.empty()) return rehash_impl(scene, 0, false, context...); // Metadata means a swiss table organized the cells
+				if(Base::adapter.organized == Base::size()) return true;
+				return insert_added(scene, context...);
 			}
 
-			// bool insert(scene& scene, const kv_pair& key_value, bool maybeRehash = true) {
-			// 	if(maybeRehash && current_size() >= Base::size() * maxLoadFactor) // Takes a linear scan so that we don't need to store extra size information...
-			// 		resize_and_rehash(scene);
+			/**
+			* @brief Forces the next rehash to rebuild the whole table
+			* @note Needed after keys are modified in place
+			*/
+			inline void mark_dirty() { Base::adapter.dirty = true; }
 
-			// 	if(find_position(key(key_value)))
-			// 		return false;  // Key already exists
+			// Number of occupied cells in the table
+			inline size_t occupied() const { return current_size(); }
 
-			// 	if(!insert_impl(scene, key_value)) return false;
-			// 	return true;
-			// }
-
-			inline std::optional<entity> find(const key_type& key) const {
-				if(auto index = find_position(key))
+			template<typename... Context>
+			inline std::optional<entity> find(const key_type& key, const Context&... context) const {
+				if(auto index = find_position(key, context...))
 					return Base::data()[*index].entity;
 				return {};  // Key not found
 			}
 
-			inline std::optional<entity> rehash_and_find(scene& scene, const key_type& key) {
-				if(!rehash(scene)) return {};
-				return find(key);
+			template<typename... Context>
+			inline std::optional<entity> rehash_and_find(scene& scene, const key_type& key, const Context&... context) {
+				if(!rehash(scene, context...)) return {};
+				return find(key, context...);
 			}
 
-			bool remove(scene& scene, const key_type& key) {
-				auto index = find_position(key);
-				if(!index)
-					return false;  // Key not found
+			/**
+			* @brief Associates a key with an entity, placing it directly into the table (the scene is updated to show the entity has the component)
+			*
+			* @param scene The scene the hashtable belongs to
+			* @param e The entity which should own the key (if it already owns a key, that key is removed first)
+			* @param key The key to insert
+			* @param context Extra state (such as the owning module) passed along to the hasher and key comparisons
+			* @return The inserted cell (so a value can be assigned), or nothing if the key is already present
+			* @note Amortized O(1), cells are only moved to make room in the key's neighborhood, and the table is only rebuilt when it grows
+			*/
+			template<typename... Context>
+			optional_reference<component_t> insert(scene& scene, entity e, const key_type& key, const Context&... context) {
+				if(!rehash(scene, context...)) return {};
+				if(find_position(key, context...)) return {}; // Key already exists
+				if(size_t index = Base::index_of(e); index != Base::invalid) erase_at(scene, index, context...);
+
+				if(buckets() == 0 || Base::adapter.count + 1 > buckets() * maxLoadFactor)
+					if(!resize_and_rehash(scene, 0, context...)) return {};
+				size_t home = this->hash(key, context...);
+				auto slot = make_room(scene, home);
+				for(size_t retries = 0; !slot; ++retries) {
+					if(retries >= MaxRetries || !resize_and_rehash(scene, 0, context...)) return {};
+					home = this->hash(key, context...);
+					slot = make_room(scene, home);
+				}
 
-				// TODO: need to modify the scene to mark that the entity no longer has a component
+				// Empty cells owned by an entity (which never marked them occupied) are swapped out of the table rather than taken over
+				if(Base::entities[*slot] != invalid_entity) {
+					if(!Base::allocate(1)) return {};
+					Base::data()[Base::size() - 1].entity = invalid_entity;
+					size_t hopInfo = Base::data()[*slot]->hopInfo;
+					if(!Base::swap(scene, *slot, Base::size() - 1, true)) return {};
+					Base::data()[*slot]->hopInfo = hopInfo;
+					Base::data()[Base::size() - 1]->hopInfo = 0;
+					Base::adapter.organized = Base::size();
+				}
 
-				Base::data()[*index].set_occupied(false);
+				auto& cell = Base::data()[*slot];
+				cell->key = key;
+				if constexpr(!std::is_void_v<value_type>) cell->value = value_type{};
+				if constexpr(store_hash) cell->hash = home;
+				cell->set_occupied(true);
+				Base::data()[home]->hopInfo |= (1 << distance(home, *slot));
+				detail::claim_cell(scene, *this, *slot, e);
+				++Base::adapter.count;
+				Base::adapter.dirty = false; // Making room only moved cells within their neighborhoods
+				return {cell};
+			}
 
-				// Update hop information of neighbors
-				auto hash = this->hash(key);
-				for(size_t i = 0; i < NeighborhoodSize; ++i) {
-					size_t probe = (hash + i) % Base::size();
-					if(Base::data()[probe]->is_occupied())
-						Base::data()[probe]->hopInfo &= ~(1 << (*index > i ? *index - i : Base::size() - (i - *index)));
-				}
+			/**
+			* @brief Removes a key from the table (and its entity's component) without moving any other cells
+			*
+			* @return true if the key was present
+			*/
+			template<typename... Context>
+			bool remove(scene& scene, const key_type& key, const Context&... context) {
+				if(!rehash(scene, context...)) return false;
+				auto index = find_position(key, context...);
+				if(!index)
+					return false;  // Key not found
+				erase_at(scene, *index, context...);
+				return true;
+			}
 
+			/**
+			* @brief Removes the key owned by an entity (and the entity's component) without moving any other cells
+			*
+			* @return true if the entity owned a key
+			*/
+			template<typename... Context>
+			bool erase(scene& scene, entity e, const Context&... context) {
+				if(!rehash(scene, context...)) return false;
+				size_t index = Base::index_of(e);
+				if(index == Base::invalid) return false;
+				erase_at(scene, index, context...);
 				return true;
 			}
 		};
 
+		namespace swiss {
+			namespace detail {
+				// Empty and deleted control bytes have their high bit set, occupied cells store the low 7 bits of their key's hash
+				constexpr uint8_t empty = 0x80, deleted = 0xFE;
+
+				// A group of control bytes which can all be compared against a tag at once
+				struct control_group {
+					static constexpr size_t width = 16;
+#if defined(ECS_HASHTABLE_SSE2)
+					__m128i control;
+					explicit control_group(const uint8_t* bytes) : control(_mm_loadu_si128((const __m128i*)bytes)) {}
+					// Bitmask with a bit set for every control byte equal to the tag
+					inline uint32_t match(uint8_t tag) const { return _mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(tag))); }
+					// Bitmask with a bit set for every empty or deleted control byte
+					inline uint32_t match_available() const { return _mm_movemask_epi8(control); }
+#elif defined(ECS_HASHTABLE_NEON)
+					uint8x16_t control;
+					explicit control_group(const uint8_t* bytes) : control(vld1q_u8(bytes)) {}
+					static inline uint32_t to_bitmask(uint8x16_t lanes) { // Keep one bit from each lane, then add each half's bits together
+						static constexpr uint8_t bits[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+						uint8x16_t masked = vandq_u8(lanes, vld1q_u8(bits));
+						return vaddv_u8(vget_low_u8(masked)) | (uint32_t(vaddv_u8(vget_high_u8(masked))) << 8);
+					}
+					inline uint32_t match(uint8_t tag) const { return to_bitmask(vceqq_u8(control, vdupq_n_u8(tag))); }
+					inline uint32_t match_available() const { return to_bitmask(vcltzq_s8(vreinterpretq_s8_u8(control))); }
+#else
+					const uint8_t* control;
+					explicit control_group(const uint8_t* bytes) : control(bytes) {}
+					inline uint32_t match(uint8_t tag) const {
+						uint32_t mask = 0;
+						for(size_t i = 0; i < width; ++i)
+							mask |= uint32_t(control[i] == tag) << i;
+						return mask;
+					}
+					inline uint32_t match_available() const {
+						uint32_t mask = 0;
+						for(size_t i = 0; i < width; ++i)
+							mask |= uint32_t(control[i] >> 7) << i;
+						return mask;
+					}
+#endif
+					inline uint32_t match_empty() const { return match(empty); }
+				};
+			}
+
+			// An adapter over a component storage which treats the underlying data as a swiss table
+			// 	(cells are found by scanning groups of one byte tags, stored in the storage's metadata, 16 at a time)
+			// NOTE: Shares its cells with hashtable::component_storage, but a storage should only be viewed through one of them at a time
+			template<
+				typename Tkey,
+				typename Tvalue = void,
+				typename Hash = std::hash<Tkey>,
+				size_t Unique = 0,
+				size_t OneOverOneMinusMaxLoadFactor = /*one_over_one_minus(.875)*/8
+			>
+			class component_storage
+				: public typed::component_storage<
+					component_wrapper<ecs::detail::remove_with_entity_t<Tkey>, ecs::detail::remove_with_entity_t<Tvalue>>, Unique
+				>
+			{
+			protected:
+				using key_type = ecs::detail::remove_with_entity_t<Tkey>;
+				using value_type = ecs::detail::remove_with_entity_t<Tvalue>;
+				using component_t = component_wrapper<key_type, value_type>;
+				using Base = typed::component_storage<component_t, Unique>;
+				using group = detail::control_group;
+
+				static constexpr float maxLoadFactor = 1 - 1.0 / OneOverOneMinusMaxLoadFactor;
+				static constexpr bool store_hash = is_costly_to_compare_v<key_type>;
+
+				// Number of cells in the table (always a power of two multiple of the group width)
+				inline size_t buckets() const { return Base::adapter.capacity; }
+				inline uint8_t* control() { return (uint8_t*)Base::metadata.data(); }
+				inline const uint8_t* control() const { return (const uint8_t*)Base::metadata.data(); }
+
+				size_t count_occupied() const {
+					size_t size = 0;
+					for(auto& e: Base::span())
+						if(e->is_occupied())
+							++size;
+					return size;
+				}
+				inline size_t current_size() const {
+					if(!Base::adapter.dirty) return Base::adapter.count;
+					return count_occupied();
+				}
+
+				inline float load_factor() const {
+					if(buckets() == 0) return 0;
+					return float(current_size()) / buckets();
+				}
+
+				// NOTE: The low bits pick the tag and the high bits the group, so the hash is mixed to make sure both are well distributed
+				template<typename... Context>
+				inline size_t hash(const key_type& key, const Context&... context) const {
+					uint64_t hash = ecs::hashtable::detail::hash_key<Hash>(key, context...) * 0x9E3779B97F4A7C15ull;
+					return hash ^ (hash >> 32);
+				}
+				static inline uint8_t tag(size_t hash) { return hash & 0x7F; }
+
+				// Calls visit with each group to probe for the hash (in order) until it returns true
+				template<typename F>
+				inline void probe(size_t hash, const F& visit) const {
+					size_t groups = buckets() / group::width, mask = groups - 1;
+					for(size_t g = (hash >> 7) & mask, step = 0; step < groups; g = (g + ++step) & mask) // Triangular probing visits every group once
+						if(visit(g * group::width)) return;
+				}
+
+				template<typename... Context>
+				std::optional<size_t> find_position(const key_type& key, const Context&... context) const {
+					if(buckets() == 0) return {};
+					size_t hash = this->hash(key, context...);
+					std::optional<size_t> out;
+					probe(hash, [&](size_t start) {
+						group g(control() + start);
+						for(uint32_t matches = g.match(tag(hash)); matches; matches &= matches - 1) {
+							size_t slot = start + std::countr_zero(matches);
+							auto& cell = Base::data()[slot];
+							if constexpr(store_hash) if(cell->hash != hash) continue;
+							if(ecs::hashtable::detail::keys_equal(cell->key, key, context...)) {
+								out = slot;
+								return true;
+							}
+						}
+						return g.match_empty() != 0; // An empty cell means the key was never pushed past this group
+					});
+					return out;
+				}
+
+				// Finds the first empty or deleted cell in the hash's probe sequence
+				std::optional<size_t> find_available(size_t hash) const {
+					std::optional<size_t> out;
+					probe(hash, [&](size_t start) {
+						if(uint32_t available = group(control() + start).match_available()) {
+							out = start + std::countr_zero(available);
+							return true;
+						}
+						return false;
+					});
+					return out;
+				}
+
+				// Rebuilds the table sized for the occupied cells (plus room for reserve more), gathering every cell into its slot in a single pass
+				// NOTE: Unowned cells which don't fit in the table are dropped, so tables which have had many keys removed shrink
+				template<typename... Context>
+				bool rehash_impl(size_t reserve, const Context&... context) {
+					size_t count = count_occupied();
+					size_t capacity = std::max(group::width, std::bit_ceil(size_t((count + reserve) / maxLoadFactor) + 1));
+					if(Base::size() < capacity) {
+						if(!Base::allocate(capacity - Base::size())) return false;
+						for(size_t i = 0; i < Base::size(); ++i)
+							if(!Base::data()[i]->is_occupied())
+								Base::data()[i].entity = invalid_entity;
+					}
+
+					Base::metadata.assign(capacity, std::byte{detail::empty});
+					Base::adapter.capacity = capacity;
+					std::vector<size_t> order(Base::size(), ecs::scene::component_storage::invalid), spare;
+					for(size_t i = 0; i < Base::size(); ++i)
+						if(Base::data()[i]->is_occupied()) {
+							size_t hash = this->hash(Base::data()[i]->key, context...);
+							size_t slot = *find_available(hash); // Always succeeds since the table is less than full
+							control()[slot] = tag(hash);
+							if constexpr(store_hash) Base::data()[i]->hash = hash;
+							order[slot] = i;
+						} else spare.push_back(i);
+					size_t next = 0;
+					for(size_t slot = 0; slot < capacity; ++slot)
+						if(order[slot] == ecs::scene::component_storage::invalid)
+							order[slot] = spare[next++];
+					order.resize(capacity);
+					for(; next < spare.size(); ++next)
+						if(Base::entities[spare[next]] != invalid_entity) order.push_back(spare[next]); // Owned cells have to be kept
+						else if(Base::operations->destroy) Base::operations->destroy(Base::element(spare[next]));
+					Base::gather(order);
+
+					Base::adapter.organized = Base::size();
+					Base::adapter.count = count;
+					Base::adapter.dirty = false;
+					return true;
+				}
+
+				// Removes the cell from the table (and its entity) without moving any other cells
+				void erase_at(scene& scene, size_t index) {
+					if(Base::data()[index]->is_occupied()) {
+						Base::data()[index]->set_occupied(false);
+						if(index < buckets()) control()[index] = detail::deleted; // Later keys in the probe sequence may have been pushed past this cell
+						--Base::adapter.count;
+					}
+					ecs::hashtable::detail::release_cell(scene, *this, index);
+				}
+
+				// Inserts the cells added since the last rehash into the table, only falling back to a full rehash if the table gets too full
+				template<typename... Context>
+				bool insert_added(scene& scene, const Context&... context) {
+					for(size_t i = Base::adapter.organized; i < Base::size(); ++i) {
+						if(!Base::data()[i]->is_occupied()) continue;
+						if(Base::adapter.count + 1 > buckets() * maxLoadFactor) return rehash_impl(0, context...);
+
+						size_t hash = this->hash(Base::data()[i]->key, context...);
+						size_t slot = *find_available(hash);
+						if(!Base::swap(scene, slot, i, true)) return false; // The available cell is left outside the table (and reclaimed by the next rebuild)
+						control()[slot] = tag(hash);
+						if constexpr(store_hash) Base::data()[slot]->hash = hash;
+						++Base::adapter.count;
+					}
+					Base::adapter.organized = Base::size();
+					Base::adapter.dirty = false;
+					return true;
+				}
+
+			public:
+				using component_type = component_t;
+
+				/**
+				* @brief Brings the table up to date with the cells which have been added (or modified)
+				*
+				* @param scene The scene the hashtable belongs to
+				* @param context Extra state (such as the owning module) passed along to the hasher and key comparisons
+				* @note Like hashtable::component_storage, free if nothing has changed and incremental if cells have only been added
+				*/
+				template<typename... Context>
+				inline bool rehash(scene& scene, const Context&... context) {
+					if(Base::adapter.dirty || buckets() == 0 || Base::metadata.size() != buckets()) return rehash_impl(0, context...);
+					if(Base::adapter.organized == Base::size()) return true;
+					return insert_added(scene, context...);
+				}
+
+				inline void mark_dirty() { Base::adapter.dirty = true; }
+
+				inline size_t occupied() const { return current_size(); }
+
+				template<typename... Context>
+				inline std::optional<entity> find(const key_type& key, const Context&... context) const {
+					if(auto index = find_position(key, context...))
+						return Base::data()[*index].entity;
+					return {};
+				}
+
+				template<typename... Context>
+				inline std::optional<entity> rehash_and_find(scene& scene, const key_type& key, const Context&... context) {
+					if(!rehash(scene, context...)) return {};
+					return find(key, context...);
+				}
+
+				/**
+				* @brief Associates a key with an entity, placing it directly into the table (the scene is updated to show the entity has the component)
+				*
+				* @return The inserted cell (so a value can be assigned), or nothing if the key is already present
+				* @note Amortized O(1), no other cells are moved unless the table needs to grow
+				*/
+				template<typename... Context>
+				optional_reference<component_t> insert(scene& scene, entity e, const key_type& key, const Context&... context) {
+					if(!rehash(scene, context...)) return {};
+					if(find_position(key, context...)) return {}; // Key already exists
+					if(size_t index = Base::index_of(e); index != Base::invalid) erase_at(scene, index);
+					if(Base::adapter.count + 1 > buckets() * maxLoadFactor)
+						if(!rehash_impl(1, context...)) return {};
+
+					size_t hash = this->hash(key, context...);
+					size_t slot = *find_available(hash);
+					// Empty cells owned by an entity (which never marked them occupied) are swapped out of the table rather than taken over
+					if(Base::entities[slot] != invalid_entity) {
+						if(!Base::allocate(1)) return {};
+						Base::data()[Base::size() - 1].entity = invalid_entity;
+						if(!Base::swap(scene, slot, Base::size() - 1, true)) return {};
+						Base::adapter.organized = Base::size();
+					}
+
+					auto& cell = Base::data()[slot];
+					cell->key = key;
+					if constexpr(!std::is_void_v<value_type>) cell->value = value_type{};
+					if constexpr(store_hash) cell->hash = hash;
+					cell->set_occupied(true);
+					control()[slot] = tag(hash);
+					ecs::hashtable::detail::claim_cell(scene, *this, slot, e);
+					++Base::adapter.count;
+					Base::adapter.dirty = false;
+					return {cell};
+				}
+
+				template<typename... Context>
+				bool remove(scene& scene, const key_type& key, const Context&... context) {
+					if(!rehash(scene, context...)) return false;
+					auto index = find_position(key, context...);
+					if(!index) return false;
+					erase_at(scene, *index);
+					return true;
+				}
+
+				/**
+				* @brief Removes the key owned by an entity (and the entity's component) without moving any other cells
+				*
+				* @return true if the entity owned a key
+				*/
+				template<typename... Context>
+				bool erase(scene& scene, entity e, const Context&... context) {
+					if(!rehash(scene, context...)) return false;
+					size_t index = Base::index_of(e);
+					if(index == Base::invalid) return false;
+					erase_at(scene, index);
+					return true;
+				}
+			};
+		}
+
 		template<typename Tkey, typename Tvalue = void>
 		inline void mark_occupied(component_wrapper<Tkey, Tvalue>& comp) {
 			comp->set_occupied(true);
@@ -27,6 +27,9 @@
 #define __ECS__HPP__
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cassert>
 #include <compare>
 #include <concepts>
@@ -34,14 +37,23 @@
 #include <cstring>
 #include <functional>
 #include <limits>
+#include <map>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
 #include <numeric>
 #include <optional>
 #include <queue>
+#include <ranges>
 #include <span>
 #include <stdexcept>
 #include <string>
+#include <thread>
+#include <tuple>
 #include <type_traits>
 #include <unordered_map>
+#include <utility>
+#include <vector>
 
 #ifdef __GNUC__
 	#include <new>
@@ -55,7 +67,13 @@
 * @var globalComponentCounter
 * Global component counter.
 */
-size_t globalComponentCounter = 0;
+std::atomic<size_t> globalComponentCounter = 0;
+
+/**
+* @var globalComponentLookupMutex
+* Mutex guarding the component lookup maps (and name getters).
+*/
+std::mutex globalComponentLookupMutex;
 
 /**
 * @var globalComponentForwardLookup
@@ -68,12 +86,32 @@ std::unordered_map<std::string, size_t> globalComponentForwardLookup = {};
 * Reverse lookup map for components by ID to their names.
 */
 std::unordered_map<size_t, std::string> globalComponentReverseLookup = {};
+
+#ifdef ECS_STATIC_COMPONENT_IDS
+/**
+* @var globalComponentNameGetters
+* Functions which produce the name of each statically registered component (indexed by ID).
+*/
+std::vector<std::string(*)()> globalComponentNameGetters = {};
+
+/**
+* @var globalComponentNamesBuilt
+* Number of entries in globalComponentNameGetters which have been added to the lookup maps.
+*/
+size_t globalComponentNamesBuilt = 0;
+#endif
 #else
 /**
 * @var globalComponentCounter
 * Global component counter.
 */
-extern size_t globalComponentCounter;
+extern std::atomic<size_t> globalComponentCounter;
+
+/**
+* @var globalComponentLookupMutex
+* Mutex guarding the component lookup maps (and name getters).
+*/
+extern std::mutex globalComponentLookupMutex;
 
 /**
 * @var globalComponentForwardLookup
@@ -86,6 +124,20 @@ extern std::unordered_map<std::string, size_t> globalComponentForwardLookup;
 * Reverse lookup map for components by ID to their names.
 */
 extern std::unordered_map<size_t, std::string> globalComponentReverseLookup;
+
+#ifdef ECS_STATIC_COMPONENT_IDS
+/**
+* @var globalComponentNameGetters
+* Functions which produce the name of each statically registered component (indexed by ID).
+*/
+extern std::vector<std::string(*)()> globalComponentNameGetters;
+
+/**
+* @var globalComponentNamesBuilt
+* Number of entries in globalComponentNameGetters which have been added to the lookup maps.
+*/
+extern size_t globalComponentNamesBuilt;
+#endif
 #endif
 
 namespace ecs {
@@ -164,22 +216,74 @@ namespace ecs {
 #endif
 	}
 
+	namespace detail {
+		/**
+		* @brief Get the name used to register a component in the lookup maps.
+		*/
+		template<typename T, size_t unique = 0>
+		std::string get_component_type_name() {
+			std::string type_name = get_type_name<T>();
+			if(unique > 0) type_name += std::to_string(unique);
+			return type_name;
+		}
+
+#ifdef ECS_STATIC_COMPONENT_IDS
+		/**
+		* @brief Assigns the next ID to a component, remembering how to generate its name if it is ever needed.
+		*/
+		inline size_t register_component(std::string(*name)()) {
+			std::scoped_lock lock(globalComponentLookupMutex);
+			size_t id = globalComponentCounter++;
+			if(globalComponentNameGetters.size() <= id)
+				globalComponentNameGetters.resize(id + 1, nullptr);
+			globalComponentNameGetters[id] = name;
+			return id;
+		}
+
+		/**
+		* @brief ID of a component, assigned during static initialization (so reading it needs no guard).
+		* @note Components should not be looked up from other static initializers, since initialization order across translation units is unspecified
+		*/
+		template<typename T, size_t unique = 0>
+		inline const size_t static_component_id = register_component(&get_component_type_name<T, unique>);
+
+		/**
+		* @brief Adds the names of any statically registered components which haven't been named yet to the lookup maps.
+		* @note globalComponentLookupMutex must be held by the caller
+		*/
+		inline void build_component_name_lookups() {
+			for( ; globalComponentNamesBuilt < globalComponentNameGetters.size(); ++globalComponentNamesBuilt)
+				if(auto name = globalComponentNameGetters[globalComponentNamesBuilt]; name) {
+					std::string type_name = name();
+					globalComponentForwardLookup[type_name] = globalComponentNamesBuilt;
+					globalComponentReverseLookup[globalComponentNamesBuilt] = type_name;
+				}
+		}
+#endif
+	}
+
 	/**
 	* @brief Get the global component ID for an entity and its components.
 	*
 	* This function returns the global component ID for an entity and its components.
+	* @note When ECS_STATIC_COMPONENT_IDS is defined IDs are assigned during static initialization and names are only generated once a lookup by name occurs
+	* @note Safe to call from multiple threads
 	*/
 	template<typename T, size_t unique = 0>
 	size_t get_global_component_id(T reference = {}) {
+#ifdef ECS_STATIC_COMPONENT_IDS
+		return detail::static_component_id<T, unique>;
+#else
 		static size_t id = globalComponentCounter++;
 		static bool run_once = []{
-			std::string type_name = get_type_name<T>();
-			if(unique > 0) type_name += std::to_string(unique);
+			std::string type_name = detail::get_component_type_name<T, unique>();
+			std::scoped_lock lock(globalComponentLookupMutex);
 			globalComponentForwardLookup[type_name] = id;
 			globalComponentReverseLookup[id] = type_name;
 			return true;
 		}();
 		return id;
+#endif
 	}
 
 	/**
@@ -188,6 +292,10 @@ namespace ecs {
 	* This function returns the global component ID for a given component type name.
 	*/
 	static size_t get_global_component_id_by_name(std::string_view _typename) {
+		std::scoped_lock lock(globalComponentLookupMutex);
+#ifdef ECS_STATIC_COMPONENT_IDS
+		detail::build_component_name_lookups();
+#endif
 		auto type_name = std::string(_typename);
 		if(!globalComponentForwardLookup.contains(type_name)) {
 			size_t id = globalComponentCounter++;
@@ -204,6 +312,10 @@ namespace ecs {
 	* This function returns the global component name for a given component ID.
 	*/
 	static std::string_view get_global_component_name(size_t id) {
+		std::scoped_lock lock(globalComponentLookupMutex);
+#ifdef ECS_STATIC_COMPONENT_IDS
+		detail::build_component_name_lookups();
+#endif
 		if(!globalComponentReverseLookup.contains(id))
 			return {nullptr, 0};
 
@@ -217,11 +329,53 @@ namespace ecs {
 #endif
 	using entity = ECS_ENTITY_TYPE;
 
+#ifndef ECS_SPARSE_PAGE_SIZE
+	#define ECS_SPARSE_PAGE_SIZE 4096
+#endif
+
+#ifndef ECS_STORAGE_PAGE_SIZE
+	#define ECS_STORAGE_PAGE_SIZE 256
+#endif
+
+#ifndef ECS_ARCHETYPE_CHUNK_SIZE
+	#define ECS_ARCHETYPE_CHUNK_SIZE 256
+#endif
+
+#ifndef ECS_PARALLEL_SORT_THRESHOLD
+	#define ECS_PARALLEL_SORT_THRESHOLD 32768
+#endif
+
+#ifndef ECS_SIGNATURE_BITS
+	#define ECS_SIGNATURE_BITS 128
+#endif
+
 	/**
 	 * @brief An invalid entity
 	 */
 	static constexpr size_t invalid_entity = std::numeric_limits<entity>::max();
 
+	/**
+	* @brief A reference to an entity which can detect if the entity has been released (and possibly recycled) since the handle was created
+	* @note Even generations are alive, odd generations have been released
+	*/
+	struct entity_handle {
+		entity index = invalid_entity;
+		uint32_t generation = 0;
+
+		bool operator==(const entity_handle&) const = default;
+	};
+
+
+	/**
+	* @brief Looks up where an entity is moved to by a remap table
+	*
+	* @param e The entity to look up
+	* @param remap Table mapping each old entity to its new entity
+	* @return The new entity (entities not covered by the table, such as invalid_entity, are returned unchanged)
+	*/
+	inline entity remap_entity(entity e, std::span<const entity> remap) {
+		return e < remap.size() ? remap[e] : e;
+	}
 
 	template<typename T>
 	struct with_entity {
@@ -249,6 +403,9 @@ namespace ecs {
 			if(a.entity == eA) a.entity = eB;
 			else if(a.entity == eB) a.entity = eA;
 		}
+		static void remap_entities(with_entity& a, std::span<const ecs::entity> remap) {
+			a.entity = remap_entity(a.entity, remap);
+		}
 	};
 
 	namespace detail {
@@ -271,13 +428,226 @@ namespace ecs {
 			{T::swap_entities(t, e, e)};
 		};
 
+		template<typename T>
+		concept has_remap_entities = requires(T t, std::span<const entity> remap) {
+			{T::remap_entities(t, remap)};
+		};
+
 		// From: https://stackoverflow.com/a/29753388
 		template<int N, typename... Ts>
 		using nth_type = typename std::tuple_element<N, std::tuple<Ts...>>::type;
 
 		struct void_like{};
+
+		/**
+		* @brief Determines if a component can be stored inside archetype tables
+		* @note Components which track their own entity (such as hashtables) rely on positional storage and always live in a component_storage
+		* @note Rows are moved between tables with memcpy, so only trivially copyable components are stored in them
+		*/
+		template<typename T>
+		struct is_archetype_storable : public std::bool_constant<!is_with_entity<T>::value && std::is_trivially_copyable_v<T>> {};
+		template<typename T>
+		constexpr static bool is_archetype_storable_v = is_archetype_storable<T>::value;
+	}
+
+	/**
+	* @brief Declares which fields of a component store entities, so the scene can keep them pointing at the right entities whenever entities are renumbered
+	*
+	* Components register their fields with a static member named entity_references:
+	* @code
+	* struct parent {
+	*	ecs::entity target; std::vector<ecs::entity> children;
+	*	static constexpr ecs::entity_fields entity_references{&parent::target, &parent::children};
+	* };
+	* @endcode
+	* @note Each field may be an entity, a type which itself references entities, or a range of either
+	* @note Components which are themselves a range of entities can register ecs::self_elements as a field
+	*/
+	template<typename... Fields>
+	struct entity_fields {
+		std::tuple<Fields...> fields;
+		constexpr entity_fields(Fields... fields) : fields(fields...) {}
+	};
+
+	/**
+	* @brief Field referring to the elements of a component which is itself a range of entities
+	*/
+	struct self_elements_t {};
+	inline constexpr self_elements_t self_elements = {};
+
+	namespace detail {
+		template<typename T>
+		concept has_entity_references = requires { T::entity_references.fields; };
+
+		/**
+		* @brief Determines if the scene needs to remap a component's fields when entities are renumbered
+		*/
+		template<typename T>
+		concept references_entities = has_entity_references<T> || has_remap_entities<T>;
+	}
+
+	/**
+	* @brief Remaps every entity referenced by a value (an entity, a component which references entities, or a range of either)
+	*
+	* @param value The value to update
+	* @param remap Table mapping each old entity to its new entity
+	* @note A static remap_entities provided by a type takes priority over its registered entity_references
+	*/
+	template<typename T>
+	void remap_references(T& value, std::span<const entity> remap) {
+		if constexpr(std::same_as<T, entity>) value = remap_entity(value, remap);
+		else if constexpr(detail::has_remap_entities<T>) T::remap_entities(value, remap);
+		else if constexpr(detail::has_entity_references<T>)
+			std::apply([&](const auto&... fields) {
+				([&](const auto& field) {
+					if constexpr(std::same_as<std::remove_cvref_t<decltype(field)>, self_elements_t>)
+						for(auto& element: value) remap_references(element, remap);
+					else remap_references(value.*field, remap);
+				}(fields), ...);
+			}, T::entity_references.fields);
+		else if constexpr(std::ranges::range<T>)
+			for(auto& element: value) remap_references(element, remap);
+		else static_assert(std::same_as<T, entity>, "Registered entity reference fields must be entities, types which reference entities, or ranges of them");
 	}
 
+	namespace detail {
+		/**
+		* @brief Type erased remap_references over a run of count adjacent elements
+		*/
+		using reference_remapper = void(*)(void* elements, size_t count, std::span<const entity> remap);
+
+		template<typename T>
+		void remap_references_of(void* elements, size_t count, std::span<const entity> remap) {
+			for(T* element = (T*)elements; count--; ++element)
+				remap_references(*element, remap);
+		}
+	}
+
+	/**
+	* @brief Determines if a component can be moved to a new address with memcpy (leaving nothing behind that needs to be destroyed)
+	* @note Defaults to trivially copyable types, specialize for types (such as most std::vector implementations) which are known to be relocatable
+	*/
+	template<typename T>
+	struct is_trivially_relocatable : public std::bool_constant<std::is_trivially_copyable_v<T>> {};
+	template<typename T>
+	constexpr static bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+	/**
+	* @brief Determines if a component's elements are addressed by their position in the storage (such as the cells of a hashtable)
+	* @note Storages of positional components are never compacted or sorted implicitly
+	*/
+	template<typename T>
+	struct is_positional : public std::false_type {};
+	template<typename T>
+	constexpr static bool is_positional_v = is_positional<T>::value;
+
+	/**
+	* @brief Type erased operations used to manage the lifetime of the elements of a component storage
+	* @note A null operation indicates the type is trivial in that regard and raw memory operations are used instead
+	*/
+	struct lifetime_operations {
+		/** @brief Destroys the element */
+		void(*destroy)(void* element) = nullptr;
+		/** @brief Move constructs destination from source, then destroys source */
+		void(*relocate)(void* destination, void* source) = nullptr;
+		/** @brief Copy constructs destination from source (allocator aware elements allocate from the provided resource) */
+		void(*copy)(void* destination, const void* source, std::pmr::memory_resource* resource) = nullptr;
+		/** @brief Swaps two elements */
+		void(*swap)(void* a, void* b) = nullptr;
+		/** @brief Weather or not the elements can be copied */
+		bool copyable = true;
+	};
+
+	namespace detail {
+		/**
+		* @brief Determines if a component can allocate its memory from the memory resource of the storage it is stored in (such as std::pmr::string)
+		*/
+		template<typename T>
+		concept uses_memory_resource = std::uses_allocator_v<T, std::pmr::polymorphic_allocator<>>;
+
+		/**
+		* @brief Constructs a T at destination, passing it the provided memory resource if it is allocator aware
+		*/
+		template<typename T, typename... Args>
+		inline T* construct_using_resource(void* destination, std::pmr::memory_resource* resource, Args&&... args) {
+			if constexpr(uses_memory_resource<T>)
+				return std::uninitialized_construct_using_allocator((T*)destination, std::pmr::polymorphic_allocator<>(resource), std::forward<Args>(args)...);
+			else return new(destination) T(std::forward<Args>(args)...);
+		}
+
+		template<typename T>
+		constexpr lifetime_operations make_lifetime_operations() {
+			lifetime_operations out;
+			if constexpr(!std::is_trivially_destructible_v<T>)
+				out.destroy = [](void* element) { std::destroy_at((T*)element); };
+			if constexpr(!is_trivially_relocatable_v<T>) {
+				out.relocate = [](void* destination, void* source) {
+					new(destination) T(std::move(*(T*)source));
+					std::destroy_at((T*)source);
+				};
+				out.swap = [](void* a, void* b) {
+					using std::swap;
+					swap(*(T*)a, *(T*)b);
+				};
+			}
+			if constexpr(!std::is_trivially_copyable_v<T>) {
+				if constexpr(std::is_copy_constructible_v<T>)
+					out.copy = [](void* destination, const void* source, std::pmr::memory_resource* resource) { construct_using_resource<T>(destination, resource, *(const T*)source); };
+				else out.copyable = false;
+			}
+			return out;
+		}
+
+		/**
+		* @brief The lifetime operations used by storages of T
+		*/
+		template<typename T>
+		inline constexpr lifetime_operations lifetime_operations_for = make_lifetime_operations<T>();
+	}
+
+	/**
+	* @brief Compact bitset recording which components an entity has
+	* @note Only components whose global id is less than ECS_SIGNATURE_BITS are tracked, presence of any other component must be looked up in its storage
+	*/
+	struct component_signature {
+		static constexpr size_t bits = ECS_SIGNATURE_BITS;
+		static constexpr size_t word_bits = 64;
+		std::array<uint64_t, (bits + word_bits - 1) / word_bits> words = {};
+
+		/**
+		* @brief Checks if the signature is able to track a component
+		*/
+		static constexpr bool tracks(size_t component_id) { return component_id < bits; }
+
+		/**
+		* @brief Checks if a component is present in the signature
+		*/
+		inline bool test(size_t component_id) const {
+			if(!tracks(component_id)) return false;
+			return (words[component_id / word_bits] >> (component_id % word_bits)) & 1;
+		}
+
+		/**
+		* @brief Marks a component as present (or not present) in the signature
+		*/
+		inline void set(size_t component_id, bool present = true) {
+			if(!tracks(component_id)) return;
+			uint64_t mask = uint64_t(1) << (component_id % word_bits);
+			if(present) words[component_id / word_bits] |= mask;
+			else words[component_id / word_bits] &= ~mask;
+		}
+
+		bool operator==(const component_signature&) const = default;
+	};
+
+	/**
+	* @brief The layout a scene uses to store its components
+	*/
+	enum class storage_mode {
+		sparse_set, // One storage per component type, indexed by a sparse set
+		archetype, // Entities sharing a set of components are stored together in chunked tables with one column per component
+	};
+
 
 	/**
 	* @brief Scene structure for storing and managing entities and components.
@@ -297,23 +667,143 @@ namespace ecs {
 			*/
 			size_t element_size = invalid;
 			/**
-			* @brief types stored as a container of raw bytes
-			* @note the scene will track offsets indicating where certain elements begin
+			* @brief Number of entities covered by each page of the sparse index
+			*/
+			static constexpr size_t page_size = ECS_SPARSE_PAGE_SIZE;
+			/**
+			* @brief Number of elements stored in each page of a paged storage
+			*/
+			static constexpr size_t elements_per_page = ECS_STORAGE_PAGE_SIZE;
+			/**
+			* @brief How the elements of a storage are laid out in memory
+			*/
+			enum class layout : uint8_t {
+				/** @brief Elements live in fixed size pages which are never moved, references stay valid while other elements are added */
+				paged,
+				/** @brief Elements live in a single array which may be reallocated as it grows, but can be viewed as a span */
+				contiguous,
+			} memory_layout = layout::paged;
+			/**
+			* @brief types stored as a container of raw bytes (only used by contiguous storages)
+			* @note the sparse index tracks which element belongs to which entity
+			*/
+			std::pmr::vector<std::byte> data;
+			/**
+			* @brief Fixed size blocks of raw bytes, each storing elements_per_page elements (only used by paged storages)
+			* @note Pages are allocated at their full size up front and never resized, so moving the page table never moves an element
+			*/
+			std::pmr::vector<std::pmr::vector<std::byte>> pages;
+			/**
+			* @brief Dense array storing which entity owns each element (invalid_entity if the element is unowned)
+			*/
+			std::pmr::vector<entity> entities;
+			/**
+			* @brief Paged sparse array mapping entities to the index of their element in data
+			* @note Pages are only allocated once an entity in their range receives a component
+			*/
+			std::pmr::vector<std::pmr::vector<size_t>> sparse;
+			/**
+			* @brief Extra bytes adapters may keep alongside the elements (such as the control bytes of a swiss table)
+			*/
+			std::pmr::vector<std::byte> metadata;
+			/**
+			* @brief How to destroy, move, copy, and swap the stored elements
+			*/
+			const lifetime_operations* operations = &detail::lifetime_operations_for<std::byte>;
+			/**
+			* @brief Weather the elements are addressed by their position (see is_positional)
+			*/
+			bool positional = false;
+			/**
+			* @brief Updates the entities referenced by the stored elements when entities are renumbered (null if the elements don't reference any entities)
+			*/
+			detail::reference_remapper remap_references = nullptr;
+			/**
+			* @brief Book keeping for adapters which find elements by their position (see hashtable::component_storage)
+			*/
+			struct adapter_state {
+				/** @brief Number of elements the adapter considers present (eg. occupied hashtable cells) */
+				size_t count = 0;
+				/** @brief Number of elements the adapter arranges its structure over (eg. the number of hashtable buckets) */
+				size_t capacity = 0;
+				/** @brief Number of elements the adapter has processed, elements past it have been added since */
+				size_t organized = 0;
+				/** @brief Set whenever elements are moved, removed, or renumbered, forcing the adapter to reorganize every element */
+				bool dirty = true;
+			} adapter;
+			/**
+			* @brief Incremented whenever elements are moved, removed, renumbered, or change owner in place (unlike adapter it is never rolled back, so it never repeats a value)
+			* @note Elements appended to the end don't count, structures built over the storage (see doir::Index) should track how many elements they have seen instead
 			*/
-			std::vector<std::byte> data;
+			size_t modifications = 0;
+
+			/**
+			* @brief The state of a storage when a snapshot was taken, along with copies of every page modified since
+			* @note Contiguous storages can't tell when they are modified, so all of their elements are copied up front
+			*/
+			struct page_journal {
+				size_t element_size = invalid, size = 0;
+				const lifetime_operations* operations = nullptr;
+				layout memory_layout = layout::paged;
+				bool positional = false;
+				detail::reference_remapper remap_references = nullptr;
+				adapter_state adapter;
+				std::pmr::vector<entity> entities;
+				std::pmr::vector<std::pmr::vector<size_t>> sparse;
+				std::pmr::vector<std::byte> metadata;
+				/** @brief Copy of every element (only used by contiguous storages) */
+				std::pmr::vector<std::byte> data;
+				/** @brief Copy of each page from before it was first modified (empty if the page hasn't been modified) */
+				std::pmr::vector<std::pmr::vector<std::byte>> saved;
+				/** @brief Set once a page has been saved, checked before locking so only the first write to each page takes the lock */
+				std::unique_ptr<std::atomic<bool>[]> preserved;
+				/**
+				* @brief Guards saved, so elements can be modified from several threads (see scene_view::par_for_each) while a snapshot is active
+				* @note Shared by every journal in a snapshot, since saving a page allocates from the scene's (possibly unsynchronized) memory resource
+				*/
+				std::mutex* mutex = nullptr;
+
+				page_journal(std::pmr::memory_resource* resource) : entities(resource), sparse(resource), metadata(resource), data(resource), saved(resource) {}
+				page_journal(const page_journal&) = delete;
+				~page_journal() {
+					if(!operations || !operations->destroy) return;
+					if(memory_layout == layout::contiguous)
+						for(size_t i = 0; i < size; ++i)
+							operations->destroy(data.data() + i * element_size);
+					else for(size_t page = 0; page < saved.size(); ++page)
+						for(size_t i = page * elements_per_page, end = std::min(size, i + elements_per_page); i < end && !saved[page].empty(); ++i)
+							operations->destroy(saved[page].data() + (i % elements_per_page) * element_size);
+				}
+			};
+			/**
+			* @brief Where pages are saved before they are modified (null unless a snapshot is active)
+			*/
+			page_journal* journal = nullptr;
+
+			/**
+			* @brief Storages allocate all of their memory (and that of allocator aware elements) from a memory resource
+			* @note Allows containers of storages (such as the scene's) to pass their resource along
+			*/
+			using allocator_type = std::pmr::polymorphic_allocator<>;
 
 			/**
 			* @brief Constructor for the component storage with a default element size and initialized data.
 			*/
 			component_storage() : element_size(invalid), data(1, std::byte{0}) {}
+			explicit component_storage(const allocator_type& allocator) : element_size(invalid), data(1, std::byte{0}, allocator), pages(allocator), entities(allocator), sparse(allocator), metadata(allocator) {}
 
 			/**
 			* @brief Constructor for the component storage with a specified element size and reserved memory.
 			*
 			* @param element_size The size of each component.
 			* @param reserved_element_count Number of elements to initially reserve
+			* @param operations How the elements should be destroyed, moved, copied, and swapped (defaults to raw memory operations)
+			* @param allocator Where the storage should allocate its memory from
 			*/
-			component_storage(size_t element_size, size_t reserved_element_count = 64) : element_size(element_size) { data.reserve(reserved_element_count * element_size); }
+			component_storage(size_t element_size, size_t reserved_element_count = 64, const lifetime_operations& operations = detail::lifetime_operations_for<std::byte>, const allocator_type& allocator = {})
+				: element_size(element_size), data(allocator), pages(allocator), entities(allocator), sparse(allocator), metadata(allocator), operations(&operations) {
+				entities.reserve(reserved_element_count);
+			}
 
 			/**
 			* @brief Template constructor that initializes the component storage with a specified element size and type.
@@ -322,8 +812,356 @@ namespace ecs {
 			* @param reference A reference to the component (default is an empty object).
 			* @param reserved_element_count Number of elements to initially reserve
 			*/
+			template<typename Tcomponent> requires(!std::convertible_to<Tcomponent, allocator_type>) // Allocators are passed along by containers of storages
+			explicit component_storage(Tcomponent reference = {}, size_t reserved_element_count = 64)
+				: component_storage(sizeof(Tcomponent), reserved_element_count) { install_operations<Tcomponent>(); }
+
+			component_storage(const component_storage& other) : component_storage(other, other.get_allocator()) {}
+			component_storage(const component_storage& other, const allocator_type& allocator)
+				: element_size(other.element_size), memory_layout(other.memory_layout), data(allocator), pages(allocator), entities(other.entities, allocator), sparse(other.sparse, allocator), metadata(other.metadata, allocator),
+				operations(other.operations), positional(other.positional), remap_references(other.remap_references), adapter(other.adapter), modifications(other.modifications) {
+				if(!operations->copy) {
+					data = other.data;
+					pages = other.pages;
+					return;
+				}
+				assert(operations->copyable);
+				if(is_contiguous()) data.resize(other.data.size());
+				else while(pages.size() < other.pages.size())
+					pages.emplace_back(elements_per_page * element_size, std::byte{0});
+				for(size_t i = 0, size = this->size(); i < size; ++i)
+					operations->copy(element(i), other.element(i), resource());
+			}
+			component_storage(component_storage&& other) = default;
+			component_storage(component_storage&& other, const allocator_type& allocator)
+				: component_storage(other.element_size, 0, *other.operations, allocator) {
+				*this = std::move(other);
+			}
+			component_storage& operator=(const component_storage& other) {
+				if(this != &other) *this = component_storage(other, get_allocator());
+				return *this;
+			}
+			component_storage& operator=(component_storage&& other) noexcept {
+				if(this == &other) return *this;
+				preserve_all(); // Our pages are about to be replaced
+				if(get_allocator() != other.get_allocator() && other.operations->relocate) {
+					// Our memory can't be swapped for memory from a different resource, so the elements need to be moved over one at a time
+					component_storage moved(other.element_size, 0, *other.operations, get_allocator());
+					moved.memory_layout = other.memory_layout;
+					moved.reserve(other.size());
+					if(moved.is_contiguous()) moved.data.resize(other.data.size());
+					for(size_t i = 0, size = other.size(); i < size; ++i)
+						other.relocate(moved.element(i), other.element(i));
+					moved.entities = std::move(other.entities);
+					moved.sparse = std::move(other.sparse);
+					moved.metadata = std::move(other.metadata);
+					moved.positional = other.positional;
+					moved.remap_references = other.remap_references;
+					moved.adapter = other.adapter;
+					other.data.clear(); other.pages.clear(); other.entities.clear(); other.sparse.clear(); other.metadata.clear();
+					return *this = std::move(moved);
+				}
+				destroy_elements();
+				element_size = other.element_size;
+				memory_layout = other.memory_layout;
+				data = std::move(other.data);
+				pages = std::move(other.pages);
+				entities = std::move(other.entities);
+				sparse = std::move(other.sparse);
+				metadata = std::move(other.metadata);
+				operations = other.operations;
+				positional = other.positional;
+				remap_references = other.remap_references;
+				adapter = other.adapter;
+				modifications = std::max(modifications, other.modifications) + 1; // Anything built over either storage is now stale
+				return *this;
+			}
+			~component_storage() { journal = nullptr; destroy_elements(); }
+
+			/**
+			* @brief Records everything the storage needs to know about the type it stores (how to destroy, move, copy, and swap it, if it is positional, and how to remap its entity references)
+			* @note Should only be called before any elements have been added
+			*/
 			template<typename Tcomponent>
-			component_storage(Tcomponent reference = {}, size_t reserved_element_count = 64) : component_storage(sizeof(Tcomponent), reserved_element_count) {}
+			void install_operations() {
+				operations = &detail::lifetime_operations_for<Tcomponent>;
+				positional = is_positional_v<Tcomponent>;
+				if constexpr(detail::references_entities<Tcomponent>)
+					remap_references = detail::remap_references_of<Tcomponent>;
+				else remap_references = nullptr;
+			}
+
+			inline allocator_type get_allocator() const { return entities.get_allocator(); }
+			/**
+			* @brief The memory resource the storage (and any allocator aware elements) allocate from
+			*/
+			inline std::pmr::memory_resource* resource() const { return get_allocator().resource(); }
+
+			/**
+			* @brief Runs the destructor of every stored element (without releasing any memory)
+			*/
+			void destroy_elements() {
+				if(!operations->destroy || element_size == invalid) return;
+				for(size_t i = size(); i--; )
+					operations->destroy(element(i));
+			}
+
+			/**
+			* @brief Number of bytes allocated to hold elements (including unused capacity)
+			*/
+			size_t capacity_bytes() const {
+				if(element_size == invalid) return 0;
+				if(is_contiguous()) return data.capacity();
+				return pages.size() * elements_per_page * element_size;
+			}
+
+			/**
+			* @brief Number of elements the storage can hold before it needs to grow
+			*/
+			size_t capacity() const {
+				if(element_size == invalid || element_size == 0) return 0;
+				return capacity_bytes() / element_size;
+			}
+
+			/**
+			* @brief Number of bytes used to find elements (the sparse index, the entity back-map, and any adapter metadata)
+			*/
+			size_t index_bytes() const {
+				size_t bytes = sparse.capacity() * sizeof(sparse[0]) + entities.capacity() * sizeof(entity) + metadata.capacity();
+				for(auto& page: sparse)
+					bytes += page.capacity() * sizeof(size_t);
+				return bytes;
+			}
+
+			/**
+			* @brief Number of elements owned by an entity
+			*/
+			size_t owned_count() const {
+				size_t count = 0;
+				for(size_t i = 0; i < entities.size(); ++i)
+					if(entities[i] != invalid_entity && index_of(entities[i]) == i) // Stale back-map entries don't count
+						++count;
+				return count;
+			}
+
+			/**
+			* @brief Moves the element at source into the (uninitialized) destination, leaving source uninitialized
+			*/
+			inline void relocate(void* destination, void* source) {
+				if(operations->relocate) operations->relocate(destination, source);
+				else std::memcpy(destination, source, element_size);
+			}
+
+			/**
+			* @brief Looks up the index of the element associated with an entity.
+			*
+			* @param e The entity to look up.
+			* @return The index of the entity's element, or invalid if the entity has no element in this storage.
+			*/
+			inline size_t index_of(entity e) const {
+				size_t page = e / page_size;
+				if(page >= sparse.size() || sparse[page].empty()) return invalid;
+				return sparse[page][e % page_size];
+			}
+
+			/**
+			* @brief Checks if an entity has an element in this storage.
+			*
+			* @param e The entity to check.
+			* @return true if the entity has an element, false otherwise.
+			*/
+			inline bool contains(entity e) const { return index_of(e) != invalid; }
+
+			/**
+			* @brief Looks up the entity which owns the element at a given index.
+			*
+			* @param index The index of the element.
+			* @return The owning entity, or invalid_entity if the element is unowned.
+			*/
+			inline entity entity_of(size_t index) const {
+				if(index >= entities.size()) return invalid_entity;
+				return entities[index];
+			}
+
+			/**
+			* @brief Updates the sparse index so that the entity maps to the provided element index.
+			*
+			* @param e The entity to update.
+			* @param index The index of the entity's element (invalid to mark the entity as not present).
+			*/
+			void set_index(entity e, size_t index) {
+				size_t page = e / page_size;
+				if(page >= sparse.size()) {
+					if(index == invalid) return;
+					sparse.resize(page + 1);
+				}
+				if(sparse[page].empty()) {
+					if(index == invalid) return;
+					sparse[page].resize(page_size, invalid);
+				}
+				sparse[page][e % page_size] = index;
+			}
+
+			/**
+			* @brief Takes an element away from its entity, leaving it in place as an unowned element (no elements move)
+			*
+			* @param e The entity whose element should be disowned.
+			* @return true if the entity owned an element, false otherwise.
+			*/
+			bool disown(entity e) {
+				size_t index = index_of(e);
+				if(index == invalid) return false;
+				if(index < entities.size()) entities[index] = invalid_entity; // Otherwise the back-map would still point at e, even once it is recycled
+				set_index(e, invalid);
+				++modifications;
+				return true;
+			}
+
+			/**
+			* @brief Checks if the elements of this storage can be viewed as a single array.
+			*
+			* @return true if the storage uses the contiguous layout, false otherwise.
+			*/
+			inline bool is_contiguous() const { return memory_layout == layout::contiguous; }
+
+			/**
+			* @brief Gets the raw memory of the element at a given index.
+			*
+			* @param index The index of the element (must be less than size()).
+			* @return Pointer to the first byte of the element.
+			*/
+			inline std::byte* element(size_t index) {
+				if(is_contiguous()) return data.data() + index * element_size;
+				if(journal) [[unlikely]] preserve(index / elements_per_page); // Mutable access might modify the page
+				return pages[index / elements_per_page].data() + (index % elements_per_page) * element_size;
+			}
+			inline const std::byte* element(size_t index) const {
+				if(is_contiguous()) return data.data() + index * element_size;
+				return pages[index / elements_per_page].data() + (index % elements_per_page) * element_size;
+			}
+
+			/**
+			* @brief Saves a copy of a page into the active snapshot (if it hasn't already been saved)
+			*
+			* @param page The page which is about to be modified
+			*/
+			void preserve(size_t page) {
+				if(!journal || page >= journal->saved.size()) return;
+				if(journal->preserved[page].load(std::memory_order_acquire)) return;
+				std::unique_lock<std::mutex> lock;
+				if(journal->mutex) lock = std::unique_lock(*journal->mutex);
+				if(journal->preserved[page].load(std::memory_order_relaxed)) return; // Another thread saved it while we waited
+
+				auto& copy = journal->saved[page];
+				copy.resize(elements_per_page * element_size);
+				size_t begin = page * elements_per_page, end = std::min(journal->size, begin + elements_per_page);
+				if(begin < end) {
+					if(!operations->copy) std::memcpy(copy.data(), pages[page].data(), (end - begin) * element_size);
+					else for(size_t i = 0; i < end - begin; ++i)
+						operations->copy(copy.data() + i * element_size, pages[page].data() + i * element_size, resource());
+				}
+				journal->preserved[page].store(true, std::memory_order_release);
+			}
+			/**
+			* @brief Saves a copy of every page into the active snapshot (needed before pages are modified without going through element)
+			*/
+			void preserve_all() {
+				if(journal) for(size_t page = 0; page < pages.size(); ++page)
+					preserve(page);
+			}
+
+			/**
+			* @brief Starts recording the state of this storage into a journal, so it can later be rolled back
+			* @note Paged storages only copy their index, contiguous storages copy every element
+			*/
+			void begin_snapshot(page_journal& out) {
+				assert(!journal); // Only one snapshot may be active at a time
+				assert(operations->copyable);
+				out.element_size = element_size; out.size = size(); out.operations = operations;
+				out.memory_layout = memory_layout; out.positional = positional; out.remap_references = remap_references; out.adapter = adapter;
+				out.entities.assign(entities.begin(), entities.end());
+				out.sparse.assign(sparse.begin(), sparse.end());
+				out.metadata.assign(metadata.begin(), metadata.end());
+				if(is_contiguous()) {
+					out.data.resize(data.size());
+					if(!operations->copy) std::memcpy(out.data.data(), data.data(), data.size());
+					else for(size_t i = 0; i < out.size; ++i)
+						operations->copy(out.data.data() + i * element_size, element(i), resource());
+				} else {
+					out.saved.resize(pages.size());
+					out.preserved = std::make_unique<std::atomic<bool>[]>(pages.size());
+				}
+				journal = &out;
+			}
+
+			/**
+			* @brief Rolls the storage back to the state recorded in the journal (which stays active, so the storage can be rolled back again)
+			*/
+			void rollback(page_journal& from) {
+				journal = nullptr;
+				// Destroy every element which lives in a page that was modified (or created) since the snapshot, the remaining pages are untouched
+				if(operations->destroy)
+					for(size_t i = 0, size = this->size(); i < size; ++i)
+						if(size_t page = i / elements_per_page; is_contiguous() || page >= from.saved.size() || !from.saved[page].empty())
+							operations->destroy(element(i));
+
+				element_size = from.element_size; operations = from.operations;
+				memory_layout = from.memory_layout; positional = from.positional; remap_references = from.remap_references; adapter = from.adapter;
+				++modifications;
+				entities.assign(from.entities.begin(), from.entities.end());
+				sparse.assign(from.sparse.begin(), from.sparse.end());
+				metadata.assign(from.metadata.begin(), from.metadata.end());
+				if(is_contiguous()) {
+					pages.clear();
+					data.resize(from.data.size());
+					if(!operations->copy) std::memcpy(data.data(), from.data.data(), data.size());
+					else for(size_t i = 0; i < from.size; ++i)
+						operations->copy(element(i), from.data.data() + i * element_size, resource());
+				} else {
+					data.clear();
+					pages.resize(from.saved.size());
+					for(size_t page = 0; page < pages.size(); ++page)
+						if(!from.saved[page].empty()) {
+							pages[page].swap(from.saved[page]);
+							from.saved[page].clear(); // The page now matches the snapshot again
+							from.preserved[page].store(false, std::memory_order_relaxed);
+						} else assert(pages[page].size() == elements_per_page * element_size);
+				}
+				journal = &from;
+			}
+
+			/**
+			* @brief Switches the memory layout of this storage.
+			*
+			* @param target The layout to switch to.
+			* @note Switching layouts moves every element (via memcpy), thus invalidates all outstanding references
+			*/
+			void set_layout(layout target) {
+				if(target == memory_layout || element_size == invalid) { memory_layout = target; return; }
+				preserve_all();
+				size_t count = size();
+				if(target == layout::contiguous) {
+					data.resize(count * element_size);
+					if(!operations->relocate)
+						for(size_t i = 0; i < count; i += elements_per_page)
+							std::memcpy(data.data() + i * element_size, pages[i / elements_per_page].data(), std::min(elements_per_page, count - i) * element_size);
+					else for(size_t i = 0; i < count; ++i)
+						operations->relocate(data.data() + i * element_size, element(i));
+					pages.clear();
+				} else {
+					pages.resize((count + elements_per_page - 1) / elements_per_page);
+					for(size_t i = 0; i < count; i += elements_per_page) {
+						pages[i / elements_per_page].resize(elements_per_page * element_size);
+						if(!operations->relocate)
+							std::memcpy(pages[i / elements_per_page].data(), data.data() + i * element_size, std::min(elements_per_page, count - i) * element_size);
+						else for(size_t j = i, end = std::min(i + elements_per_page, count); j < end; ++j)
+							operations->relocate(pages[i / elements_per_page].data() + (j - i) * element_size, data.data() + j * element_size);
+					}
+					data.clear();
+					data.shrink_to_fit();
+				}
+				memory_layout = target;
+			}
 
 			/**
 			* @brief Template function that retrieves a component by its entity index, if it exists and matches the expected type.
@@ -335,12 +1173,14 @@ namespace ecs {
 			template<typename Tcomponent>
 			optional_reference<const Tcomponent> get(entity e) const {
 				if (!(sizeof(Tcomponent) == element_size)) return {};
-				if (!(e < (data.size() / element_size))) return {};
-				return {*(Tcomponent*)(data.data() + e * element_size)};
+				if (!(e < size())) return {};
+				return {*(const Tcomponent*)element(e)};
 			}
 			template<typename Tcomponent>
 			optional_reference<Tcomponent> get(entity e) {
-				if (auto got = ((const component_storage*)this)->get<Tcomponent>(e); got) return {const_cast<Tcomponent&>(*got)}; else return {};
+				if (!(sizeof(Tcomponent) == element_size)) return {};
+				if (!(e < size())) return {};
+				return {*(Tcomponent*)element(e)}; // Mutable access lets snapshots know the element may be modified
 			}
 
 			/**
@@ -349,21 +1189,60 @@ namespace ecs {
 			* @tparam Tcomponent The type of component.
 			* @param count The number of components to allocate.
 			* @return An optional pair containing the allocated component and its entity index, or an empty optional if allocation fails.
+			* @note Paged storages never move existing elements, contiguous storages may reallocate (invalidating references)
 			*/
 			template<typename Tcomponent>
 			std::optional<std::pair<Tcomponent&, size_t>> allocate(size_t count = 1) {
 				if (!(sizeof(Tcomponent) == element_size)) return {};
 				// if (!(count < 100)) return {};
+				if(!is_contiguous()) {
+					size_t originalSize = size();
+					entities.resize(originalSize + count, invalid_entity);
+					while(pages.size() * elements_per_page < entities.size())
+						pages.emplace_back(elements_per_page * element_size, std::byte{0});
+					for (size_t i = originalSize; i < entities.size() - 1; i++) // Skip the last one
+						detail::construct_using_resource<Tcomponent>(element(i), resource());
+					return {{ *detail::construct_using_resource<Tcomponent>(element(entities.size() - 1), resource()), entities.size() }};
+				}
+				// Grow geometrically ourselves, so that non-trivially relocatable elements are moved properly rather than memcpyed by the vector
+				if(size_t needed = size() + count; needed * element_size > data.capacity())
+					reserve(std::max(needed, 2 * data.capacity() / element_size));
 				auto originalEnd = data.size();
 				data.insert(data.end(), element_size * count, std::byte{0});
+				entities.resize(data.size() / element_size, invalid_entity);
 				for (size_t i = 0; i < count - 1; i++) // Skip the last one
-					new(data.data() + originalEnd + i * element_size) Tcomponent();
+					detail::construct_using_resource<Tcomponent>(data.data() + originalEnd + i * element_size, resource());
 				return {{
-					*new(data.data() + data.size() - element_size) Tcomponent(),
+					*detail::construct_using_resource<Tcomponent>(data.data() + data.size() - element_size, resource()),
 					data.size() / element_size
 				}};
 			}
 
+			/**
+			* @brief Ensures the storage has room for at least count elements
+			*
+			* @param count The number of elements to make room for.
+			* @note Contiguous storages relocate their elements (invalidating references) if they need to grow
+			*/
+			void reserve(size_t count) {
+				if(element_size == invalid) return;
+				entities.reserve(count);
+				if(!is_contiguous()) {
+					while(pages.size() * elements_per_page < count)
+						pages.emplace_back(elements_per_page * element_size, std::byte{0});
+					return;
+				}
+				if(count * element_size <= data.capacity()) return;
+				if(!operations->relocate) return data.reserve(count * element_size);
+
+				std::pmr::vector<std::byte> grown(get_allocator());
+				grown.reserve(count * element_size);
+				grown.resize(data.size());
+				for(size_t i = 0, size = this->size(); i < size; ++i)
+					operations->relocate(grown.data() + i * element_size, data.data() + i * element_size);
+				data.swap(grown);
+			}
+
 			/**
 			* @brief Template function that retrieves or allocates a component by its entity index, if it doesn't exist.
 			*
@@ -374,7 +1253,7 @@ namespace ecs {
 			template<typename Tcomponent>
 			optional_reference<Tcomponent> get_or_allocate(entity e) {
 				if (!(sizeof(Tcomponent) == element_size)) return {};
-				size_t size = data.size() / element_size;
+				size_t size = this->size();
 				if (size <= e)
 					if ( !allocate<Tcomponent>(std::max<int64_t>(int64_t(e) - size + 1, 1)) ) return {};
 				return get<Tcomponent>(e);
@@ -385,8 +1264,12 @@ namespace ecs {
 			*
 			* @return How many components are currently stored inside this storage.
 			* @note Some of these components may be uninitialized!
+			* @note Paged storages always keep a back-map entry for every element, so its size doubles as the element count
 			*/
-			size_t size() const { return data.size() / element_size; }
+			size_t size() const {
+				if(!is_contiguous()) return entities.size();
+				return data.size() / element_size;
+			}
 			/**
 			* @brief Template function that checks if the component storage is empty.
 			*
@@ -399,7 +1282,7 @@ namespace ecs {
 
 			/**
 			* @brief Function which removes the value associated with the provided entity
-			* @note performs a swap with the last stored value thus needs to update offset information stored in the scene
+			* @note moves the last stored value into the removed slot thus needs to update the sparse index
 			*
 			* @tparam Tcomponent The component type to remove (calculates the component_id automatically if provided)
 			* @param scene The scene storing offset information
@@ -419,8 +1302,8 @@ namespace ecs {
 			 * @param scene The scene where book keeping information about entities is stored
 			 * @param component_id Id associated with the elements stored in this component (needed if Tcomponent not provided)
 			 * @param order A list storing which index in the current order should be in the resulting order
-			 * @note Only swaps are performed, so every element in order must be unique
-			 * @note The order generated by std::iota results in no swaps being performed
+			 * @note Every element in order must be unique
+			 * @note Elements are gathered into freshly allocated memory, so all outstanding references are invalidated
 			 */
 			template<typename Tcomponent, size_t Unique = 0>
 			void reorder(struct scene& scene, std::span<size_t> order);
@@ -452,12 +1335,23 @@ namespace ecs {
 			*/
 			template<typename Tcomponent, size_t Unique = 0>
 			void sort_by_value(struct scene& scene) {
-				constexpr static auto comparator = [](Tcomponent* a, Tcomponent* b) {
-					return std::less<Tcomponent>{}(*a, *b);
-				};
-				sort<Tcomponent, decltype(comparator), false, Unique>(scene, comparator);
+				sort_by_key<Tcomponent, Unique>(scene, [](const Tcomponent& value, entity) -> const Tcomponent& { return value; });
 			}
 
+			/**
+			* @brief Sorts all components stored in this storage by a key extracted from each of them (smallest first)
+			*
+			* @tparam Tcomponent the type of component stored in this storage
+			* @tparam KeyFn type of the key extractor, has signature: Key(const Tcomponent& component, entity owner)
+			* @param scene The scene where book keeping information about entities is stored
+			* @param key Function which extracts the key to sort each component by
+			* @note Integral, enum, and floating point keys are LSD radix sorted,
+			*	any other key is merge sorted (in parallel for storages with at least ECS_PARALLEL_SORT_THRESHOLD elements)
+			* @note Keys returned by reference are compared in place rather than copied
+			*/
+			template<typename Tcomponent, size_t Unique = 0, typename KeyFn>
+			void sort_by_key(struct scene& scene, const KeyFn& key);
+
 			/**
 			* Sorts all components stored in this storage monotonically, or in other words sorts them so that they are in the same order as
 			*	their associated entities.
@@ -471,10 +1365,83 @@ namespace ecs {
 			*/
 			template<typename Tcomponent, size_t Unique = 0>
 			void sort_monotonic(struct scene& scene) {
-				auto comparator = [](Tcomponent* a, entity eA, Tcomponent* b, entity eB) {
-					return std::less<entity>{}(eA, eB);
-				};
-				sort<Tcomponent, decltype(comparator), true, Unique>(scene, comparator);
+				sort_by_key<Tcomponent, Unique>(scene, [](const Tcomponent&, entity e) { return e; });
+			}
+
+			/**
+			* @brief Drops every element not owned by an entity and sorts the rest so they are in the same order as their entities
+			* @note Walking the sparse index visits the owned elements in entity order, so no comparison sort is needed,
+			*	the elements are then gathered into freshly allocated memory (relocating each exactly once)
+			* @note Moves every element, thus invalidates all outstanding references
+			*/
+			void compact() {
+				if(element_size == invalid) return;
+				size_t count = size();
+				std::vector<size_t> order; order.reserve(count);
+				for(auto& page: sparse)
+					for(size_t index: page) // Unallocated pages are empty
+						if(index != invalid) order.push_back(index);
+
+				// Destroy any elements which aren't referenced by the sparse index
+				if(operations->destroy && order.size() != count) {
+					std::vector<bool> owned(count, false);
+					for(size_t index: order) owned[index] = true;
+					for(size_t i = 0; i < count; ++i)
+						if(!owned[i]) operations->destroy(element(i));
+				}
+				gather(order);
+			}
+
+			/**
+			* @brief Replaces the elements with a selection of the current elements, gathered into freshly allocated memory
+			*
+			* @param order Which current element should be stored at each index of the result (each element may appear at most once)
+			* @note Elements not listed in order must have already been destroyed
+			* @note Each element is relocated exactly once, thus invalidates all outstanding references
+			*/
+			void gather(std::span<const size_t> order) {
+				preserve_all(); // Every page is about to be replaced
+				adapter.dirty = true; ++modifications;
+				component_storage out(element_size, 0, *operations, get_allocator());
+				out.memory_layout = memory_layout;
+				out.reserve(order.size());
+				if(is_contiguous()) out.data.resize(order.size() * element_size);
+				out.entities.resize(order.size(), invalid_entity);
+				for(size_t i = 0; i < order.size(); ++i) {
+					size_t index = order[i];
+					relocate(out.element(i), element(index));
+					if(entity e = entities[index]; e != invalid_entity && index_of(e) == index) // Leave unowned elements unowned
+						out.entities[i] = e;
+				}
+				for(size_t i = 0; i < order.size(); ++i)
+					if(out.entities[i] != invalid_entity)
+						set_index(out.entities[i], i);
+
+				// Every element has been relocated (or destroyed), so the old memory can be released without running any destructors
+				data = std::move(out.data);
+				pages = std::move(out.pages);
+				entities = std::move(out.entities);
+			}
+
+			/**
+			* @brief Updates the back-map and sparse index after entities have been renumbered (the elements themselves don't move)
+			*
+			* @param remap Table mapping each old entity to its new entity
+			*/
+			void remap_entities(std::span<const entity> remap) {
+				++modifications;
+				auto old = std::move(sparse);
+				sparse.clear();
+				for(size_t i = 0; i < entities.size(); ++i) {
+					entity e = entities[i];
+					if(e == invalid_entity) continue;
+					if(e / page_size >= old.size() || old[e / page_size].empty() || old[e / page_size][e % page_size] != i) {
+						entities[i] = invalid_entity; // The back-map was stale, the element is unowned
+						continue;
+					}
+					entities[i] = remap_entity(e, remap);
+					set_index(entities[i], i);
+				}
 			}
 
 		friend struct scene;
@@ -494,9 +1461,10 @@ namespace ecs {
 				if(a > size()) return false;
 				if(b > size()) return false;
 
-				Tcomponent* aPtr = (Tcomponent*)(data.data() + a * sizeof(Tcomponent));
-				Tcomponent* bPtr = (Tcomponent*)(data.data() + b * sizeof(Tcomponent));
+				Tcomponent* aPtr = (Tcomponent*)element(a);
+				Tcomponent* bPtr = (Tcomponent*)element(b);
 				std::swap(*aPtr, *bPtr);
+				adapter.dirty = true; ++modifications;
 				return true;
 			}
 			bool swap(size_t a, std::optional<size_t> _b = {}, std::vector<std::byte>& buffer = []() -> std::vector<std::byte>& {
@@ -511,8 +1479,13 @@ namespace ecs {
 				if(a > size()) return false;
 				if(b > size()) return false;
 
-				void* aPtr = data.data() + a * element_size;
-				void* bPtr = data.data() + b * element_size;
+				void* aPtr = element(a);
+				void* bPtr = element(b);
+				adapter.dirty = true; ++modifications;
+				if(operations->swap) {
+					operations->swap(aPtr, bPtr);
+					return true;
+				}
 				std::memcpy(buffer.data(), aPtr, element_size);
 				std::memcpy(aPtr, bPtr, element_size);
 				std::memcpy(bPtr, buffer.data(), element_size);
@@ -556,75 +1529,557 @@ namespace ecs {
 		};
 
 		/**
-		* @brief Vector of entity offsets, where each offsets represents an entity's component indices in the storage.
+		* @brief A table storing every entity which has exactly the same set of (archetype storable) components.
+		* @note Rows are split into fixed size chunks, each chunk stores its columns one after another (SoA)
+		*/
+		struct archetype {
+			/**
+			* @brief An invalid index value.
+			*/
+			static constexpr size_t invalid = std::numeric_limits<size_t>::max();
+			/**
+			* @brief Number of rows stored in each chunk
+			*/
+			static constexpr size_t chunk_size = ECS_ARCHETYPE_CHUNK_SIZE;
+
+			/**
+			* @brief Sorted list of component ids stored in this archetype (one per column)
+			*/
+			std::vector<size_t> components;
+			/**
+			* @brief Size (in bytes) of the elements stored in each column
+			*/
+			std::vector<size_t> element_sizes;
+			/**
+			* @brief Offset (in bytes) of each column from the start of a chunk
+			*/
+			std::vector<size_t> offsets;
+			/**
+			* @brief Lookup table mapping component ids to columns (invalid if the component isn't present)
+			*/
+			std::vector<size_t> column_lookup;
+			/**
+			* @brief Raw memory for each chunk of rows
+			*/
+			std::pmr::vector<std::pmr::vector<std::byte>> chunks;
+			/**
+			* @brief The entity stored in each row
+			*/
+			std::vector<entity> entities;
+			/**
+			* @brief Cached transitions to the archetypes with a component added or removed
+			*/
+			std::unordered_map<size_t, size_t> add_edges, remove_edges;
+
+			archetype() = default;
+			explicit archetype(const std::pmr::polymorphic_allocator<>& allocator) : chunks(allocator) {}
+			archetype(std::vector<size_t> _components, const std::pmr::vector<component_storage>& storages) : components(std::move(_components)), chunks(storages.get_allocator()) {
+				size_t offset = 0;
+				for(size_t i = 0; i < components.size(); ++i) {
+					size_t id = components[i];
+					element_sizes.push_back(storages[id].element_size);
+					offsets.push_back(offset);
+					offset += storages[id].element_size * chunk_size;
+					if(column_lookup.size() <= id) column_lookup.resize(id + 1, invalid);
+					column_lookup[id] = i;
+				}
+			}
+
+			/**
+			* @brief Gets the column storing the provided component
+			*
+			* @param component_id The component to look for
+			* @return The index of the column, or invalid if this archetype doesn't store the component
+			*/
+			inline size_t column_of(size_t component_id) const {
+				if(component_id >= column_lookup.size()) return invalid;
+				return column_lookup[component_id];
+			}
+			inline bool contains(size_t component_id) const { return column_of(component_id) != invalid; }
+
+			/**
+			* @brief Number of rows stored in this archetype
+			*/
+			inline size_t size() const { return entities.size(); }
+
+			/**
+			* @brief Gets a pointer to the element at the provided column and row
+			*/
+			inline std::byte* get(size_t column, size_t row) {
+				return chunks[row / chunk_size].data() + offsets[column] + (row % chunk_size) * element_sizes[column];
+			}
+			inline const std::byte* get(size_t column, size_t row) const {
+				return chunks[row / chunk_size].data() + offsets[column] + (row % chunk_size) * element_sizes[column];
+			}
+
+			/**
+			* @brief Adds a new (uninitialized) row for the provided entity
+			*
+			* @return The index of the new row
+			*/
+			size_t allocate(entity e) {
+				size_t row = entities.size();
+				if(row % chunk_size == 0) {
+					size_t bytes = offsets.empty() ? 0 : offsets.back() + element_sizes.back() * chunk_size;
+					chunks.emplace_back(bytes, std::byte{0});
+				}
+				entities.push_back(e);
+				return row;
+			}
+
+			/**
+			* @brief Sorts the rows so that they are in the same order as their entities
+			* @note Rows are gathered into freshly allocated chunks
+			*/
+			void sort_by_entity() {
+				if(std::is_sorted(entities.begin(), entities.end())) return;
+				std::vector<size_t> order(entities.size());
+				std::iota(order.begin(), order.end(), 0);
+				std::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return entities[a] < entities[b]; });
+
+				archetype sorted(chunks.get_allocator()); // Constructed (rather than assigned) with our allocator, since polymorphic allocators don't propagate on assignment
+				sorted.components = components; sorted.element_sizes = element_sizes; sorted.offsets = offsets;
+				for(size_t row: order) {
+					size_t to = sorted.allocate(entities[row]);
+					for(size_t c = 0; c < components.size(); ++c)
+						std::memcpy(sorted.get(c, to), get(c, row), element_sizes[c]);
+				}
+				chunks = std::move(sorted.chunks);
+				entities = std::move(sorted.entities);
+			}
+
+			/**
+			* @brief Removes a row by moving the last row into its place
+			*
+			* @return The entity whose row was moved (invalid_entity if no row needed to move)
+			*/
+			entity remove(size_t row) {
+				size_t last = entities.size() - 1;
+				entity moved = invalid_entity;
+				if(row != last) {
+					for(size_t c = 0; c < components.size(); ++c)
+						std::memcpy(get(c, row), get(c, last), element_sizes[c]);
+					moved = entities[row] = entities[last];
+				}
+				entities.pop_back();
+				if(entities.size() % chunk_size == 0) chunks.pop_back();
+				return moved;
+			}
+		};
+
+		/**
+		* @brief Where in the archetype tables an entity is stored
+		*/
+		struct entity_location {
+			size_t archetype = 0, row = archetype::invalid;
+		};
+
+		/**
+		* @brief The layout used to store (archetype storable) components
+		* @note Should only be changed before any components have been added
+		*/
+		storage_mode mode = storage_mode::sparse_set;
+
+		/**
+		* @brief Archetype tables (only used when in archetype mode)
+		*/
+		std::vector<archetype> archetypes;
+
+		/**
+		* @brief Lookup from sorted component id lists to the associated archetype
+		*/
+		std::map<std::vector<size_t>, size_t> archetype_lookup;
+
+		/**
+		* @brief Where each entity is stored (only used when in archetype mode)
+		*/
+		std::pmr::vector<entity_location> entity_locations;
+
+		/**
+		* @brief Incremented whenever an entity enters, leaves, or is renumbered within the archetype tables (rows moving within a table don't count)
+		* @note Lets structures built over archetype stored components tell when they are out of date
+		*/
+		size_t archetype_modifications = 0;
+
+		/**
+		* @brief Number of entities which have been created in this scene (including those on the free list)
+		*/
+		size_t entity_count = 0;
+
+		/**
+		* @brief Which components each entity has
+		*/
+		std::pmr::vector<component_signature> signatures;
+
+		/**
+		* @brief Vector of storage objects for storing and retrieving components.
+		*/
+		std::pmr::vector<component_storage> storages;
+
+		/**
+		* @brief Queue of available entities that can be reused.
+		* @note Entities are recycled in the order they were released so that stale ids take as long as possible to alias a new entity
+		*/
+		std::queue<entity> freelist;
+
+		/**
+		* @brief How many times each entity has been released or recycled (even while alive, odd while on the free list)
+		*/
+		std::pmr::vector<uint32_t> generations;
+
+		/**
+		* @brief Creates an empty scene
+		*
+		* @param resource Where the scene should allocate its book keeping, storages, and allocator aware components from
+		* @note The resource must outlive the scene
+		*/
+		scene(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+			: entity_locations(resource), signatures(resource), storages(resource), generations(resource) {
+			storages.reserve(64);
+			storages.emplace_back();
+		}
+
+		/**
+		* @brief The memory resource the scene allocates from
+		*/
+		inline std::pmr::memory_resource* resource() const { return storages.get_allocator().resource(); }
+
+		/**
+		* @brief Get the size of the scene, excluding free entities if ignoreFree is false.
+		*
+		* @param ignoreFree Whether to include free entities in the count.
+		* @return The size of the scene.
+		*/
+		template<bool ignoreFree = false>
+		size_t size() const {
+			size_t size = entity_count;
+			if constexpr(!ignoreFree) size -= freelist.size();
+			return size;
+		}
+
+		/**
+		* @brief Get a reference to a storage object for the given component type.
+		*
+		* @tparam Tcomponent The component type to retrieve.
+		* @return An optional reference to the storage object, or an empty optional if the storage does not exist.
+		*/
+		template<typename Tcomponent, size_t Unique = 0>
+		optional_reference<component_storage> get_storage() {
+			size_t id = get_global_component_id<Tcomponent, Unique>();
+			if(storages.size() <= id)
+				storages.resize(id + 1);
+			if (storages[id].element_size == component_storage::invalid) {
+				storages[id] = component_storage(sizeof(Tcomponent), 64, detail::lifetime_operations_for<Tcomponent>, storages.get_allocator()); // NOTE: Passing Tcomponent{} would select the element size constructor for integral components!
+				storages[id].template install_operations<Tcomponent>();
+			}
+			return {storages[id]};
+		}
+		template<typename Tcomponent, size_t Unique = 0>
+		optional_reference<const component_storage> get_storage() const {
+			size_t id = get_global_component_id<Tcomponent, Unique>();
+			if(!(storages.size() > id)) return {};
+			if(!(storages[id].element_size != component_storage::invalid)) return {};
+			return {storages[id]};
+		}
+
+		/**
+		* @brief Release a storage object for the given component type freeing all of the memory of the associated components
+		*
+		* @tparam Tcomponent The component type to release.
+		* @return Whether the release was successful.
+		*/
+		template<typename Tcomponent, size_t Unique = 0>
+		bool release_storage() {
+			size_t id = get_global_component_id<Tcomponent, Unique>();
+			if(storages.size() <= id) return false;
+			if(storages[id].element_size == component_storage::invalid) return false;
+			storages[id] = component_storage(storages.get_allocator());
+			return true;
+		}
+
+		/**
+		* @brief A saved copy of the state of a scene, which the scene can be rolled back to
+		* @note Paged storages are copy on write, only pages modified after the snapshot was taken are copied (contiguous storages and archetype tables are copied up front)
+		* @note Only one snapshot may be active per scene at a time, and the scene must not be moved or destroyed while a snapshot of it is alive
+		*/
+		struct snapshot {
+			scene* owner = nullptr;
+			storage_mode mode;
+			std::vector<archetype> archetypes;
+			std::map<std::vector<size_t>, size_t> archetype_lookup;
+			std::pmr::vector<entity_location> entity_locations;
+			size_t entity_count;
+			std::pmr::vector<component_signature> signatures;
+			std::queue<entity> freelist;
+			std::pmr::vector<uint32_t> generations;
+			/** @brief The journal recording each storage (null if the storage didn't exist when the snapshot was taken) */
+			std::vector<std::unique_ptr<component_storage::page_journal>> journals;
+			/** @brief Shared by every journal, so pages saved from several threads don't race on the scene's memory resource */
+			std::unique_ptr<std::mutex> mutex = std::make_unique<std::mutex>();
+
+			snapshot(scene& owner) : owner(&owner), mode(owner.mode), archetypes(owner.archetypes), archetype_lookup(owner.archetype_lookup),
+				entity_locations(owner.entity_locations, owner.resource()), entity_count(owner.entity_count), signatures(owner.signatures, owner.resource()),
+				freelist(owner.freelist), generations(owner.generations, owner.resource()), journals(owner.storages.size()) {
+				for(size_t id = 0; id < owner.storages.size(); ++id)
+					if(owner.storages[id].element_size != component_storage::invalid) {
+						journals[id] = std::make_unique<component_storage::page_journal>(owner.resource());
+						journals[id]->mutex = mutex.get();
+						owner.storages[id].begin_snapshot(*journals[id]);
+					}
+			}
+			snapshot(const snapshot&) = delete;
+			snapshot(snapshot&& other) = default;
+			snapshot& operator=(const snapshot&) = delete;
+			snapshot& operator=(snapshot&&) = delete;
+			~snapshot() {
+				if(!owner) return;
+				for(size_t id = 0; id < journals.size(); ++id)
+					if(journals[id] && owner->storages[id].journal == journals[id].get())
+						owner->storages[id].journal = nullptr;
+			}
+		};
+
+		/**
+		* @brief Takes a snapshot of the scene which the scene can later be restored to (see restore)
+		* @note Useful for speculative passes which might need to undo all of their changes
+		*/
+		snapshot take_snapshot() { return snapshot(*this); }
+
+		/**
+		* @brief Rolls the scene back to the state it was in when the snapshot was taken
+		* @note The snapshot remains active afterwards, so the scene can be restored to it again
+		*
+		* @param from The snapshot (of this scene) to restore
+		*/
+		void restore(snapshot& from) {
+			assert(from.owner == this);
+			for(size_t id = 0; id < storages.size(); ++id)
+				if(id < from.journals.size() && from.journals[id])
+					storages[id].rollback(*from.journals[id]);
+				else if(storages[id].element_size != component_storage::invalid)
+					storages[id] = component_storage(storages.get_allocator()); // Storage created after the snapshot
+
+			mode = from.mode;
+			archetypes = from.archetypes;
+			archetype_lookup = from.archetype_lookup;
+			entity_locations = from.entity_locations;
+			++archetype_modifications;
+			entity_count = from.entity_count;
+			signatures = from.signatures;
+			freelist = from.freelist;
+			generations = from.generations;
+		}
+
+		/**
+		* @brief Memory used by the components of a single type
+		*/
+		struct storage_statistics {
+			size_t component_id;
+			/**
+			* @brief Name of the component type (see get_global_component_name)
+			*/
+			std::string_view name;
+			/**
+			* @brief Number of components owned by an entity
+			*/
+			size_t element_count = 0;
+			size_t element_size = 0;
+			/**
+			* @brief Bytes allocated to hold components (including unused capacity)
+			*/
+			size_t capacity_bytes = 0;
+			/**
+			* @brief Bytes used to find components (the sparse index and entity back-map)
+			*/
+			size_t index_bytes = 0;
+
+			/**
+			* @brief Fraction of the allocated component memory not holding an owned component (unowned elements, holes in pages, and unused capacity)
+			*/
+			double fragmentation() const { return capacity_bytes ? 1 - double(element_count * element_size) / capacity_bytes : 0; }
+		};
+
+		/**
+		* @brief Memory used by a scene, broken down per component type
 		*/
-		std::vector<std::vector<size_t>> entity_component_indices;
+		struct memory_statistics {
+			/**
+			* @brief Statistics for every component type with allocated memory
+			*/
+			std::vector<storage_statistics> storages;
+			/**
+			* @brief Bytes allocated to hold components (summed across every storage)
+			*/
+			size_t component_bytes = 0;
+			/**
+			* @brief Bytes used by entity component indices (the sparse indices and back-maps of every storage)
+			*/
+			size_t entity_component_indices_bytes = 0;
+			/**
+			* @brief Bytes used by per entity book keeping (signatures, generations, the free list, and archetype locations)
+			*/
+			size_t entity_bytes = 0;
+
+			size_t total_bytes() const { return component_bytes + entity_component_indices_bytes + entity_bytes; }
+		};
 
 		/**
-		* @brief Vector of storage objects for storing and retrieving components.
+		* @brief Reports how much memory the scene is using, and which components it is used by
+		*
+		* @return Statistics for each component (ordered by component id) along with totals for the whole scene
+		* @note Walks every storage and archetype table, so is intended for diagnostics rather than hot paths
 		*/
-		std::vector<component_storage> storages = []{
-			std::vector<component_storage> out = {component_storage()};
-			out.reserve(64);
+		memory_statistics statistics() const {
+			std::vector<storage_statistics> per_id(storages.size());
+			for(size_t id = 0; id < storages.size(); ++id) {
+				auto& storage = storages[id];
+				per_id[id].component_id = id;
+				if(storage.element_size == component_storage::invalid) continue;
+				per_id[id].element_size = storage.element_size;
+				per_id[id].element_count = storage.owned_count();
+				per_id[id].capacity_bytes = storage.capacity_bytes();
+				per_id[id].index_bytes = storage.index_bytes();
+			}
+
+			memory_statistics out;
+			out.entity_bytes = signatures.capacity() * sizeof(component_signature) + generations.capacity() * sizeof(uint32_t)
+				+ freelist.size() * sizeof(entity) + entity_locations.capacity() * sizeof(entity_location);
+			for(auto& table: archetypes) {
+				out.entity_bytes += table.entities.capacity() * sizeof(entity); // Archetype rows are found through entity_locations
+				for(size_t column = 0; column < table.components.size(); ++column) {
+					auto& stats = per_id[table.components[column]];
+					stats.element_size = table.element_sizes[column];
+					stats.element_count += table.size();
+					stats.capacity_bytes += table.chunks.size() * archetype::chunk_size * table.element_sizes[column];
+				}
+			}
+
+			for(auto& stats: per_id) {
+				if(stats.capacity_bytes == 0 && stats.index_bytes == 0) continue;
+				stats.name = get_global_component_name(stats.component_id);
+				out.component_bytes += stats.capacity_bytes;
+				out.entity_component_indices_bytes += stats.index_bytes;
+				out.storages.push_back(stats);
+			}
 			return out;
-		}();
+		}
 
 		/**
-		* @brief Queue of available entities that can be reused.
+		* @brief Gets where an entity is stored in the archetype tables
+		*
+		* @param e The entity to look up
+		* @return The entity's location (its row is invalid if it isn't stored in any archetype)
 		*/
-		std::queue<entity> freelist;
+		entity_location location(entity e) const {
+			if(e >= entity_locations.size()) return {};
+			return entity_locations[e];
+		}
 
 		/**
-		* @brief Get the size of the scene, excluding free entities if ignoreFree is false.
+		* @brief Finds (or creates) the archetype reached by adding or removing a component from another archetype
 		*
-		* @param ignoreFree Whether to include free entities in the count.
-		* @return The size of the scene.
+		* @param from The archetype to start from
+		* @param component_id The component to add or remove
+		* @param add Weather the component should be added or removed
+		* @return The index of the resulting archetype
 		*/
-		template<bool ignoreFree = false>
-		size_t size() const {
-			size_t size = entity_component_indices.size();
-			if constexpr(!ignoreFree) size -= freelist.size();
-			return size;
+		size_t archetype_transition(size_t from, size_t component_id, bool add) {
+			if(archetypes.empty()) {
+				archetypes.emplace_back(storages.get_allocator()); // The archetype of entities without any components
+				archetype_lookup[{}] = 0;
+			}
+
+			auto& edges = add ? archetypes[from].add_edges : archetypes[from].remove_edges;
+			if(auto found = edges.find(component_id); found != edges.end())
+				return found->second;
+
+			std::vector<size_t> components = archetypes[from].components;
+			if(add) components.insert(std::upper_bound(components.begin(), components.end(), component_id), component_id);
+			else std::erase(components, component_id);
+
+			size_t target;
+			if(auto found = archetype_lookup.find(components); found != archetype_lookup.end())
+				target = found->second;
+			else {
+				target = archetypes.size();
+				archetype_lookup[components] = target;
+				archetypes.emplace_back(std::move(components), storages);
+			}
+
+			(add ? archetypes[from].add_edges : archetypes[from].remove_edges)[component_id] = target;
+			return target;
 		}
 
 		/**
-		* @brief Get a reference to a storage object for the given component type.
+		* @brief Moves an entity into a new archetype, copying every component the two archetypes share
 		*
-		* @tparam Tcomponent The component type to retrieve.
-		* @return An optional reference to the storage object, or an empty optional if the storage does not exist.
+		* @param e The entity to move
+		* @param target The archetype to move the entity into
+		* @return The entity's new location
 		*/
-		template<typename Tcomponent, size_t Unique = 0>
-		optional_reference<component_storage> get_storage() {
-			size_t id = get_global_component_id<Tcomponent, Unique>();
-			if(storages.size() <= id)
-				storages.resize(id + 1, component_storage());
-			if (storages[id].element_size == component_storage::invalid)
-				storages[id] = component_storage(Tcomponent{});
-			return {storages[id]};
-		}
-		template<typename Tcomponent, size_t Unique = 0>
-		optional_reference<const component_storage> get_storage() const {
-			size_t id = get_global_component_id<Tcomponent, Unique>();
-			if(!(storages.size() > id)) return {};
-			if(!(storages[id].element_size != component_storage::invalid)) return {};
-			return {storages[id]};
+		entity_location move_entity(entity e, size_t target) {
+			if(entity_locations.size() <= e) entity_locations.resize(e + 1);
+			auto& loc = entity_locations[e];
+			auto& to = archetypes[target];
+			size_t row = to.allocate(e);
+			++archetype_modifications;
+
+			if(loc.row != archetype::invalid) {
+				auto& from = archetypes[loc.archetype];
+				for(size_t c = 0; c < from.components.size(); ++c)
+					if(size_t column = to.column_of(from.components[c]); column != archetype::invalid)
+						std::memcpy(to.get(column, row), from.get(c, loc.row), from.element_sizes[c]);
+				if(entity moved = from.remove(loc.row); moved != invalid_entity)
+					entity_locations[moved].row = loc.row;
+			}
+			return loc = {target, row};
 		}
 
 		/**
-		* @brief Release a storage object for the given component type freeing all of the memory of the associated components
+		* @brief Removes an entity from the archetype tables
 		*
-		* @tparam Tcomponent The component type to release.
-		* @return Whether the release was successful.
+		* @param e The entity to remove
+		* @return true if the entity was stored in an archetype, false otherwise
 		*/
-		template<typename Tcomponent, size_t Unique = 0>
-		bool release_storage() {
-			size_t id = get_global_component_id<Tcomponent, Unique>();
-			if(storages.size() <= id) return false;
-			if(storages[id].element_size == component_storage::invalid) return false;
-			storages[id] = component_storage();
+		bool release_entity_location(entity e) {
+			if(e >= entity_locations.size()) return false;
+			auto& loc = entity_locations[e];
+			if(loc.row == archetype::invalid) return false;
+			if(entity moved = archetypes[loc.archetype].remove(loc.row); moved != invalid_entity)
+				entity_locations[moved].row = loc.row;
+			loc = {};
+			++archetype_modifications;
 			return true;
 		}
 
+		/**
+		* @brief Gets the signature recording which (tracked) components an entity has
+		*
+		* @param e The entity to look up
+		* @return The entity's signature
+		*/
+		const component_signature& signature(entity e) const {
+			static const component_signature empty = {};
+			if(e >= signatures.size()) return empty;
+			return signatures[e];
+		}
+
+		/**
+		* @brief Records the presence (or absence) of a component in an entity's signature
+		*
+		* @param e The entity to update
+		* @param component_id The component which was added or removed
+		* @param present Weather the component is now present
+		*/
+		void update_signature(entity e, size_t component_id, bool present) {
+			if(!component_signature::tracks(component_id)) return;
+			if(e >= signatures.size()) {
+				if(!present) return;
+				signatures.resize(std::max<size_t>(e + 1, signatures.size() * 2));
+			}
+			signatures[e].set(component_id, present);
+		}
+
 		/**
 		* @brief Create a new entity and add it to the scene.
 		*
@@ -632,34 +2087,150 @@ namespace ecs {
 		*/
 		entity create_entity() {
 			if(freelist.empty()) {
-				entity e = entity_component_indices.size();
-				entity_component_indices.emplace_back(std::vector<size_t>{component_storage::invalid});
-				return e;
+				if(generations.size() <= entity_count) generations.resize(entity_count + 1, 0);
+				return entity_count++;
 			}
 
-			entity e = freelist.back();
-			entity_component_indices[e] = std::vector<size_t>{component_storage::invalid};
+			entity e = freelist.front();
 			freelist.pop();
+			++generations[e];
 			return e;
 		}
 
+		/**
+		* @brief Create several new entities with consecutive IDs.
+		*
+		* @param count The number of entities to create.
+		* @return The ID of the first created entity (the rest follow it).
+		* @note The free list is not consulted, so the entities are always consecutive
+		*/
+		entity create_entities(size_t count) {
+			entity first = entity_count;
+			entity_count += count;
+			generations.resize(entity_count, 0);
+			return first;
+		}
+
+		/**
+		* @brief Ensures the scene's entity book keeping has room for at least count entities
+		*
+		* @param count The total number of entities to make room for.
+		*/
+		void reserve_entities(size_t count) {
+			generations.reserve(count);
+			signatures.reserve(count);
+			if(mode == storage_mode::archetype) entity_locations.reserve(count);
+		}
+
+		/**
+		* @brief Ensures the storage for a component has room for at least count components
+		*
+		* @tparam Tcomponent The component type to reserve room for.
+		* @param count The total number of components to make room for.
+		*/
+		template<typename Tcomponent, size_t Unique = 0>
+		void reserve_components(size_t count) {
+			if constexpr(detail::is_archetype_storable_v<Tcomponent>)
+				if(mode == storage_mode::archetype) return; // Stored in the archetype tables instead
+			get_storage<Tcomponent, Unique>()->reserve(count);
+		}
+
+		/**
+		* @brief Ensures the storage for a component has room for count more components, growing geometrically so repeated calls stay amortized linear
+		*
+		* @tparam Tcomponent The component type to make room for.
+		* @param count The number of components about to be added.
+		*/
+		template<typename Tcomponent, size_t Unique = 0>
+		void grow_components(size_t count) {
+			if constexpr(detail::is_archetype_storable_v<Tcomponent>)
+				if(mode == storage_mode::archetype) return;
+			auto& storage = *get_storage<Tcomponent, Unique>();
+			if(size_t needed = storage.size() + count; needed > storage.capacity())
+				storage.reserve(std::max(needed, 2 * storage.capacity()));
+		}
+
+		/**
+		* @brief Create a new entity and get a generational handle to it.
+		*
+		* @return A handle to the newly created entity.
+		*/
+		entity_handle create_entity_handle() { return handle(create_entity()); }
+
+		/**
+		* @brief Gets a generational handle to an entity.
+		*
+		* @param e The ID of the entity.
+		* @return A handle which stays valid until the entity is released.
+		*/
+		entity_handle handle(entity e) const {
+			return {e, e < generations.size() ? generations[e] : 0};
+		}
+
+		/**
+		* @brief Checks if an entity has been created and not released.
+		*
+		* @param e The ID of the entity to check.
+		* @return true if the entity is alive, false otherwise.
+		*/
+		bool is_alive(entity e) const {
+			if(e >= entity_count) return false;
+			return e >= generations.size() || generations[e] % 2 == 0;
+		}
+
+		/**
+		* @brief Checks if a handle still refers to the entity it was created for.
+		*
+		* @param h The handle to check.
+		* @return true if the entity is alive and has not been recycled since the handle was created, false otherwise.
+		*/
+		bool is_valid(entity_handle h) const {
+			return is_alive(h.index) && handle(h.index).generation == h.generation;
+		}
+
 		/**
 		* @brief Release an entity back to the free list.
 		*
 		* @param e The ID of the entity to release.
 		* @param clearMemory Weather all of the components associated with the entity should be removed or not!
-		* @return True if the entity was successfully released, false otherwise.
+		* @return True if the entity was successfully released, false otherwise (for example if it has already been released).
+		* @note Only the storages the entity occupies are visited, so releasing costs O(components on the entity) plus
+		*	the number of storages whose ids are too large to be tracked by signatures
 		*/
 		bool release_entity(entity e, bool clearMemory = true) {
-			if(e >= entity_component_indices.size()) return false;
-
-			if(clearMemory && !storages.empty()) for(size_t i = storages.size() - 1; i--; )
-				storages[i].remove(*this, e, i);
+			if(!is_alive(e)) return false;
 
-			entity_component_indices[e] = std::vector<size_t>{component_storage::invalid};
+			auto release_from = [&, this](size_t id) {
+				if(clearMemory) storages[id].remove(*this, e, id);
+				else storages[id].disown(e);
+			};
+			const component_signature sig = signature(e); // Copy since removal updates the signature
+			for(size_t w = 0; w < sig.words.size(); ++w)
+				for(uint64_t bits = sig.words[w]; bits; bits &= bits - 1)
+					if(size_t id = w * component_signature::word_bits + std::countr_zero(bits); id < storages.size())
+						release_from(id);
+			for(size_t id = component_signature::bits; id < storages.size(); ++id)
+				release_from(id);
+			if(mode == storage_mode::archetype)
+				release_entity_location(e);
+			if(e < signatures.size()) signatures[e] = {};
+
+			if(generations.size() <= e) generations.resize(e + 1, 0);
+			++generations[e];
 			freelist.emplace(e);
 			return true;
 		}
+		/**
+		* @brief Release the entity referred to by a handle back to the free list.
+		*
+		* @param h Handle to the entity to release.
+		* @param clearMemory Weather all of the components associated with the entity should be removed or not!
+		* @return True if the entity was successfully released, false otherwise (for example if the handle is stale).
+		*/
+		bool release_entity(entity_handle h, bool clearMemory = true) {
+			if(!is_valid(h)) return false;
+			return release_entity(h.index, clearMemory);
+		}
 
 		/**
 		* @brief Add a component to an entity and store it in the scene's storage.
@@ -667,20 +2238,79 @@ namespace ecs {
 		* @tparam Tcomponent The component type to add.
 		* @param e The ID of the entity to add the component to.
 		* @return An optional reference to the added component, or an empty optional if the addition failed.
+		* @note If the entity already has the component, it is reset to a default constructed value rather than a second copy being allocated
 		*/
 		template<typename Tcomponent, size_t Unique = 0>
 		optional_reference<Tcomponent> add_component(entity e) {
-			size_t id = get_global_component_id<Tcomponent, Unique>();
-			auto& indices = entity_component_indices[e];
-			if(indices.empty() || indices.size() <= id)
-				indices.resize(id + 1, component_storage::invalid);
-			indices[id] = get_storage<Tcomponent, Unique>()->size();
-			auto opt = get_storage<Tcomponent, Unique>()->template get_or_allocate<Tcomponent>(indices[id]);
+			auto& storage = *get_storage<Tcomponent, Unique>();
+			if constexpr(detail::is_archetype_storable_v<Tcomponent>) if(mode == storage_mode::archetype) {
+				size_t id = get_global_component_id<Tcomponent, Unique>();
+				auto loc = location(e);
+				if(loc.row != archetype::invalid)
+					if(size_t column = archetypes[loc.archetype].column_of(id); column != archetype::invalid) {
+						auto& out = *(Tcomponent*)archetypes[loc.archetype].get(column, loc.row);
+						return {out = Tcomponent{}};
+					}
+
+				loc = move_entity(e, archetype_transition(loc.row == archetype::invalid ? 0 : loc.archetype, id, true));
+				update_signature(e, id, true);
+				auto& table = archetypes[loc.archetype];
+				return {*new(table.get(table.column_of(id), loc.row)) Tcomponent()};
+			}
+
+			optional_reference<Tcomponent> opt;
+			if(size_t index = storage.index_of(e); index != component_storage::invalid) {
+				opt = storage.template get<Tcomponent>(index);
+				if(opt) *opt = Tcomponent{};
+			} else {
+				index = storage.size();
+				opt = storage.template get_or_allocate<Tcomponent>(index);
+				if(!opt) return {};
+				storage.entities[index] = e;
+				storage.set_index(e, index);
+				update_signature(e, get_global_component_id<Tcomponent, Unique>(), true);
+			}
 			if constexpr(detail::is_with_entity_v<Tcomponent>)
 				if(opt) opt->entity = e;
 			return opt;
 		}
 
+		/**
+		* @brief Add several components to every entity in a range.
+		*
+		* @tparam Unique Tag distinguishing several storages of the same component types.
+		* @tparam Tcomponents The component types to add.
+		* @param entities The entities to add the components to.
+		* @param init Function called with each entity and references to its newly added components (which are otherwise left default constructed)
+		*	has signature: void(entity e, Tcomponents&... components)
+		* @return The number of entities which received every component
+		* @note When the size of the range is known each storage grows (geometrically) at most once up front, rather than potentially once per entity
+		* @note If any component can't be added to an entity, the components this call added to it are removed again (ones it already had stay, reset)
+		*/
+		template<size_t Unique, typename... Tcomponents, std::ranges::input_range Range, typename F = decltype([](entity, Tcomponents&...) {})>
+		size_t add_components_bulk(Range&& entities, const F& init = {}) {
+			if constexpr(std::ranges::sized_range<Range>)
+				(grow_components<Tcomponents, Unique>(std::ranges::size(entities)), ...);
+
+			size_t added = 0;
+			for(entity e: entities) {
+				std::array<bool, sizeof...(Tcomponents)> had = {has_component<Tcomponents, Unique>(e)...};
+				if(!(add_component<Tcomponents, Unique>(e) && ...)) {
+					size_t i = 0;
+					(void(had[i++] || remove_component<Tcomponents, Unique>(e)), ...);
+					continue;
+				}
+				// Looked up again after every component is added, since adding to an archetype moves the entity's other components
+				std::invoke(init, e, *get_component<Tcomponents, Unique>(e)...);
+				++added;
+			}
+			return added;
+		}
+		template<typename... Tcomponents, std::ranges::input_range Range, typename F = decltype([](entity, Tcomponents&...) {})>
+		size_t add_components_bulk(Range&& entities, const F& init = {}) {
+			return add_components_bulk<0, Tcomponents...>(std::forward<Range>(entities), init);
+		}
+
 		/**
 		* @brief Remove a component from an entity and release the associated storage.
 		* @note this function is named remove rather than release since the associated memory is deleted... rather than a "tombstone being placed"
@@ -690,7 +2320,17 @@ namespace ecs {
 		* @return true if the removal was successful, false otherwise.
 		*/
 		template<typename Tcomponent, size_t Unique = 0>
-		bool remove_component(entity e) { return get_storage<Tcomponent, Unique>()->template remove<Tcomponent>(*this, e); }
+		bool remove_component(entity e) {
+			if constexpr(detail::is_archetype_storable_v<Tcomponent>) if(mode == storage_mode::archetype) {
+				size_t id = get_global_component_id<Tcomponent, Unique>();
+				auto loc = location(e);
+				if(loc.row == archetype::invalid || !archetypes[loc.archetype].contains(id)) return false;
+				move_entity(e, archetype_transition(loc.archetype, id, false));
+				update_signature(e, id, false);
+				return true;
+			}
+			return get_storage<Tcomponent, Unique>()->template remove<Tcomponent>(*this, e);
+		}
 
 		/**
 		* @brief Get a reference to the component associated with an entity.
@@ -701,20 +2341,32 @@ namespace ecs {
 		*/
 		template<typename Tcomponent, size_t Unique = 0>
 		optional_reference<Tcomponent> get_component(entity e) {
+			if constexpr(detail::is_archetype_storable_v<Tcomponent>) if(mode == storage_mode::archetype) {
+				if(auto got = ((const scene*)this)->get_component<Tcomponent, Unique>(e); got) return {const_cast<Tcomponent&>(*got)};
+				return {};
+			}
 			size_t id = get_global_component_id<Tcomponent, Unique>();
-			if(e >= entity_component_indices.size()) return {};
-			if(entity_component_indices[e].size() <= id) return {};
-			if(entity_component_indices[e][id] == component_storage::invalid) return {};
-			return get_storage<Tcomponent, Unique>()->template get<Tcomponent>(entity_component_indices[e][id]);
+			if(storages.size() <= id) return {};
+			auto& storage = storages[id];
+			size_t index = storage.index_of(e);
+			if(index == component_storage::invalid) return {};
+			return storage.template get<Tcomponent>(index); // Mutable access lets snapshots know the element may be modified
 		}
 		template<typename Tcomponent, size_t Unique = 0>
 		optional_reference<const Tcomponent> get_component(entity e) const {
 			size_t id = get_global_component_id<Tcomponent, Unique>();
-			if(e >= entity_component_indices.size()) return {};
-			if(entity_component_indices[e].size() <= id) return {};
-			if(entity_component_indices[e][id] == component_storage::invalid) return {};
-			if(auto s = get_storage<Tcomponent, Unique>(); s) return s->template get<Tcomponent>(entity_component_indices[e][id]);
-			return {};
+			if constexpr(detail::is_archetype_storable_v<Tcomponent>) if(mode == storage_mode::archetype) {
+				auto loc = location(e);
+				if(loc.row == archetype::invalid) return {};
+				size_t column = archetypes[loc.archetype].column_of(id);
+				if(column == archetype::invalid) return {};
+				return {*(const Tcomponent*)archetypes[loc.archetype].get(column, loc.row)};
+			}
+			if(storages.size() <= id) return {};
+			auto& storage = storages[id];
+			size_t index = storage.index_of(e);
+			if(index == component_storage::invalid) return {};
+			return storage.template get<Tcomponent>(index);
 		}
 
 		/**
@@ -727,71 +2379,282 @@ namespace ecs {
 		template<typename Tcomponent, size_t Unique = 0>
 		bool has_component(entity e) const {
 			size_t id = get_global_component_id<Tcomponent, Unique>();
-			return entity_component_indices.size() > e && entity_component_indices[e].size() > id && entity_component_indices[e][id] != component_storage::invalid;
+			if constexpr(detail::is_archetype_storable_v<Tcomponent>) if(mode == storage_mode::archetype) {
+				auto loc = location(e);
+				return loc.row != archetype::invalid && archetypes[loc.archetype].contains(id);
+			}
+			if(component_signature::tracks(id)) return signature(e).test(id);
+			return storages.size() > id && storages[id].contains(e);
+		}
+
+		/**
+		* @brief Finds the first of several components which is present on an entity
+		*
+		* @tparam Tcomponents The components to check for (in priority order)
+		* @param e The ID of the entity to check the components on.
+		* @return The index (into Tcomponents) of the first present component, or sizeof...(Tcomponents) if none are present
+		* @note Tracked components are read out of the entity's signature and combined into a mask, so no per component branching is needed
+		*/
+		template<typename... Tcomponents>
+		size_t first_component_of(entity e) const {
+			static_assert(sizeof...(Tcomponents) < 64, "At most 63 components can be checked at once");
+			const auto& sig = signature(e);
+			uint64_t present = uint64_t(1) << sizeof...(Tcomponents); // Sentinel bit so that none present results in sizeof...(Tcomponents)
+			size_t i = 0;
+			([&] {
+				size_t id = get_global_component_id<Tcomponents>();
+				bool has = component_signature::tracks(id) ? sig.test(id) : has_component<Tcomponents>(e);
+				present |= uint64_t(has) << i++;
+			}(), ...);
+			return std::countr_zero(present);
 		}
 
 	protected:
 		template<typename Tcomponent, size_t Unique = 0>
 		struct NotifySwapOp {
 			inline bool operator()(scene& self, entity a, entity b) const {
-				// if constexpr(!detail::has_swap_entities<Tcomponent>) return true;
+				if constexpr(detail::references_entities<Tcomponent>) return true; // Updated by remap_entity_references instead
+				if constexpr(detail::is_archetype_storable_v<Tcomponent>) if(self.mode == storage_mode::archetype) {
+					size_t id = get_global_component_id<Tcomponent, Unique>();
+					for(auto& table: self.archetypes)
+						if(size_t column = table.column_of(id); column != archetype::invalid)
+							for(size_t row = table.size(); row--; )
+								Tcomponent::swap_entities(*(Tcomponent*)table.get(column, row), a, b);
+					return true;
+				}
 				auto& storage = *self.get_storage<Tcomponent, Unique>();
-				Tcomponent* data = (Tcomponent*)storage.data.data();
-				for(size_t i = storage.size(); i--; ) {
-					// This commented code runs half as fast as the current code!
-					// if(!self.has_component<Tcomponent>(i)) continue;
-					// Tcomponent::swap_entities(*self.get_component<Tcomponent>(i), a, b);
-					Tcomponent::swap_entities(data[i], a, b);
+				// Walk the storage a page (or the whole array) at a time
+				size_t run = storage.is_contiguous() ? storage.size() : component_storage::elements_per_page;
+				for(size_t start = 0; start < storage.size(); start += run) {
+					Tcomponent* data = (Tcomponent*)storage.element(start);
+					for(size_t i = std::min(run, storage.size() - start); i--; ) {
+						// This commented code runs half as fast as the current code!
+						// if(!self.has_component<Tcomponent>(i)) continue;
+						// Tcomponent::swap_entities(*self.get_component<Tcomponent>(i), a, b);
+						Tcomponent::swap_entities(data[i], a, b);
+					}
 				}
 				return true;
 			}
 		};
+		/**
+		 * @brief Swaps the book keeping of two entities (without updating any registered entity references)
+		 */
+		template<typename... Tcomponents2notify>
+		void swap_entity_records(entity a, entity b) {
+			if constexpr(sizeof...(Tcomponents2notify) > 0)
+				[&, this]<std::size_t... I>(std::index_sequence<I...>) {
+					(NotifySwapOp<detail::nth_type<I, Tcomponents2notify...>>{}(*this, a, b) && ...);
+				}(std::make_index_sequence<sizeof...(Tcomponents2notify)>{});
+
+			for(auto& storage: storages) {
+				size_t iA = storage.index_of(a), iB = storage.index_of(b);
+				if(iA == component_storage::invalid && iB == component_storage::invalid) continue;
+				storage.set_index(a, iB);
+				storage.set_index(b, iA);
+				if(iA != component_storage::invalid) storage.entities[iA] = b;
+				if(iB != component_storage::invalid) storage.entities[iB] = a;
+				storage.adapter.dirty = true; ++storage.modifications; // Anything built over the storage now maps these elements to the wrong entities
+			}
+
+			if(signatures.size() <= std::max(a, b)) signatures.resize(std::max(a, b) + 1);
+			std::swap(signatures[a], signatures[b]);
+
+			if(mode == storage_mode::archetype) {
+				if(entity_locations.size() <= std::max(a, b)) entity_locations.resize(std::max(a, b) + 1);
+				std::swap(entity_locations[a], entity_locations[b]);
+				if(auto& loc = entity_locations[a]; loc.row != archetype::invalid) archetypes[loc.archetype].entities[loc.row] = a;
+				if(auto& loc = entity_locations[b]; loc.row != archetype::invalid) archetypes[loc.archetype].entities[loc.row] = b;
+				++archetype_modifications;
+			}
+		}
+
+		inline bool tracks_entity_references() const {
+			return std::ranges::any_of(storages, [](const component_storage& storage) { return storage.remap_references != nullptr; });
+		}
+
+		/**
+		 * @brief Identity remap table reused by swap_entities (only the swapped entries are changed, and only for the duration of the swap)
+		 */
+		std::vector<entity> swap_remap;
+
+		/**
+		 * @brief Moves the generations (and free list entries) of two swapped entities along with them
+		 * @note Both generations are advanced (keeping whether they are alive), so handles taken before the swap no longer validate
+		 */
+		void swap_generations(entity a, entity b) {
+			if(a == b) return;
+			if(generations.size() <= std::max(a, b)) generations.resize(std::max(a, b) + 1, 0);
+			std::swap(generations[a], generations[b]);
+			generations[a] += 2; generations[b] += 2;
+			if(generations[a] % 2 != generations[b] % 2) { // One of them was on the free list
+				std::queue<entity> swappedFree;
+				for(; !freelist.empty(); freelist.pop())
+					swappedFree.push(freelist.front() == a ? b : freelist.front() == b ? a : freelist.front());
+				freelist = std::move(swappedFree);
+			}
+		}
+
+		/**
+		 * @brief Moves every entity's generation (and free list entry) according to a remap table
+		 * @note The generation of every entity which moves is advanced (keeping whether it is alive), so handles taken before the move no longer validate
+		 */
+		void remap_generations(std::span<const entity> remap) {
+			std::pmr::vector<uint32_t> to(std::max(generations.size(), remap.size()), 0, generations.get_allocator());
+			for(entity e = 0; e < to.size(); ++e) {
+				entity moved = remap_entity(e, remap);
+				to[moved] = (e < generations.size() ? generations[e] : 0) + (moved == e ? 0 : 2);
+			}
+			generations = std::move(to);
+
+			std::queue<entity> remappedFree;
+			for(; !freelist.empty(); freelist.pop())
+				remappedFree.push(remap_entity(freelist.front(), remap));
+			freelist = std::move(remappedFree);
+		}
 	public:
 		/**
 		 * @brief Swap two entities
 		 *
-		 * @tparam Tcomponents2notify list of components that should be notified of the swap
+		 * @tparam Tcomponents2notify list of unregistered components (providing a static swap_entities) that should be notified of the swap
 		 * @param a first entity to swap
 		 * @param _b second entity to swap (if not provided swaps with the last entity)
+		 * @note Components with registered entity references are updated automatically, which visits every one of their elements,
+		 *	so many swaps should be applied together (see the overload taking a list of swaps, or reorder_entities)
+		 * @note Handles to either entity are invalidated
 		 */
 		template<typename... Tcomponents2notify>
 		void swap_entities(entity a, std::optional<entity> _b = {}) {
-			entity b = _b.value_or(entity_component_indices.size() - 1);
-
-			[&, this]<std::size_t... I>(std::index_sequence<I...>) {
-				(NotifySwapOp<detail::nth_type<I, Tcomponents2notify...>>{}(*this, a, b) && ...);
-			}(std::make_index_sequence<sizeof...(Tcomponents2notify)>{});
+			entity b = _b.value_or(entity_count - 1);
+			swap_entity_records<Tcomponents2notify...>(a, b);
+			swap_generations(a, b);
+
+			if(tracks_entity_references()) {
+				if(size_t size = std::max<size_t>({a + 1, b + 1, entity_count}); swap_remap.size() < size) {
+					size_t identity = swap_remap.size();
+					swap_remap.resize(size);
+					std::iota(swap_remap.begin() + identity, swap_remap.end(), identity);
+				}
+				swap_remap[a] = b; swap_remap[b] = a;
+				remap_entity_references(swap_remap);
+				swap_remap[a] = a; swap_remap[b] = b;
+			}
+		}
 
-			// Seams to be slightly faster than using std::swap (but within the margin of error!)
-			auto tmp = std::move(entity_component_indices[a]);
-			entity_component_indices[a] = std::move(entity_component_indices[b]);
-			entity_component_indices[b] = std::move(tmp);
-			// std::swap(entity_component_indices[a], entity_component_indices[b]);
+		/**
+		 * @brief Applies a list of swaps (in order)
+		 *
+		 * @tparam Tcomponents2notify list of unregistered components (providing a static swap_entities) that should be notified of each swap
+		 * @param swaps The pairs of entities to swap
+		 * @note Components with registered entity references (and generations) are updated in a single pass once every swap has been applied
+		 * @note Handles to every entity which moves are invalidated
+		 */
+		template<typename... Tcomponents2notify>
+		void swap_entities(std::span<const std::pair<entity, entity>> swaps) {
+			// Follow which entity ends up where, so the references can be remapped all at once
+			size_t size = entity_count;
+			for(auto [a, b]: swaps) size = std::max<size_t>({size, a + 1, b + 1});
+			std::vector<entity> at(size);
+			std::iota(at.begin(), at.end(), 0);
+			for(auto [a, b]: swaps) {
+				swap_entity_records<Tcomponents2notify...>(a, b);
+				std::swap(at[a], at[b]);
+			}
+			std::vector<entity> remap(size);
+			for(entity e = 0; e < size; ++e)
+				remap[at[e]] = e;
+			remap_generations(remap);
+			if(tracks_entity_references()) remap_entity_references(remap);
 		}
 
 		/**
 		 * @brief Sorts the entities so they are in the specified order
 		 *
-		 * @tparam Tcomponents2notify list of components that should be notified of any swaps
+		 * @tparam Tcomponents2notify list of unregistered components (providing a static swap_entities) that should be notified of any swaps
 		 * @param order A list storing which index in the current order should be in the resulting order
-		 * @note Only swaps are performed, so every element in order must be unique
-		 * @note The order generated by std::iota results in no swaps being performed
+		 * @note Every element in order must be unique
+		 * @note Components with registered entity references (see entity_fields) are updated automatically in a single pass
+		 * @note Handles to every entity which moves are invalidated
 		 */
 		template<typename... Tcomponents2notify>
 		void reorder_entities(const std::span<size_t> order) {
 			assert(order.size() == size()); // Require order to have an entry for every element in the array
 
-			std::vector<size_t> swaps(order.size(), 0);
-			// Transpose the order (it now stores what needs to be swapped with what)
+			// Build a table of where every entity moves to
+			std::vector<entity> remap(order.size());
 			for(size_t i = 0; i < order.size(); i++)
-				swaps[order[i]] = i;
+				remap[order[i]] = i;
+
+			// Components which can only be notified one swap at a time need the permutation applied as a chain of swaps
+			if constexpr(!(detail::references_entities<Tcomponents2notify> && ...)) {
+				std::vector<size_t> swaps(order.size(), 0);
+				// Transpose the order (it now stores what needs to be swapped with what)
+				for(size_t i = 0; i < order.size(); i++)
+					swaps[order[i]] = i;
+
+				// Update the data storage and book keeping
+				for(size_t i = 0; i < swaps.size(); ++i)
+					while(swaps[i] != i) {
+						swap_entity_records<Tcomponents2notify...>(swaps[i], i);
+						std::swap(swaps[swaps[i]], swaps[i]);
+					}
+				remap_generations(remap);
+				remap_entity_references(remap);
+			} else remap_entities(remap); // Otherwise apply the whole table in a single pass
+		}
 
-			// Update the data storage and book keeping
-			for(size_t i = 0; i < swaps.size(); ++i)
-				while(swaps[i] != i) {
-					swap_entities<Tcomponents2notify...>(swaps[i], i);
-					std::swap(swaps[swaps[i]], swaps[i]);
-				}
+		/**
+		 * @brief Updates every registered entity reference (see entity_fields) according to a remap table
+		 *
+		 * @param remap Table mapping each old entity to its new entity
+		 * @note Called automatically when entities are reordered, should be called after entities are renumbered by any other means (such as merging scenes)
+		 */
+		void remap_entity_references(std::span<const entity> remap) {
+			for(size_t id = 0; id < storages.size(); ++id) {
+				auto& storage = storages[id];
+				if(!storage.remap_references) continue;
+				storage.adapter.dirty = true; ++storage.modifications; // Keys which reference entities may have changed
+
+				// Walk the storage a page (or the whole array) at a time
+				size_t run = storage.is_contiguous() ? storage.size() : component_storage::elements_per_page;
+				for(size_t start = 0; start < storage.size(); start += run)
+					storage.remap_references(storage.element(start), std::min(run, storage.size() - start), remap);
+
+				if(mode == storage_mode::archetype)
+					for(auto& table: archetypes)
+						if(size_t column = table.column_of(id); column != archetype::invalid)
+							for(size_t row = 0; row < table.size(); row += archetype::chunk_size)
+								storage.remap_references(table.get(column, row), std::min(archetype::chunk_size, table.size() - row), remap);
+			}
+		}
+
+		/**
+		 * @brief Renumbers every entity according to a remap table
+		 *
+		 * @param remap Table mapping each old entity to its new entity (must be a permutation)
+		 * @note Components don't move, only the book keeping is rebuilt (into fresh buffers), so the cost is O(entities + components)
+		 * @note Every registered entity reference is remapped as well, and handles to every entity which moves are invalidated
+		 */
+		void remap_entities(std::span<const entity> remap) {
+			remap_entity_references(remap);
+			for(auto& storage: storages)
+				storage.remap_entities(remap);
+
+			auto gather = [&remap](auto& from, auto fill) {
+				std::remove_cvref_t<decltype(from)> to(std::max(from.size(), remap.size()), fill, from.get_allocator());
+				for(size_t e = 0; e < from.size(); ++e)
+					to[remap_entity(e, remap)] = from[e];
+				from = std::move(to);
+			};
+			gather(signatures, component_signature{});
+			remap_generations(remap);
+			if(mode == storage_mode::archetype) {
+				gather(entity_locations, entity_location{});
+				for(auto& table: archetypes)
+					for(auto& e: table.entities)
+						e = remap_entity(e, remap);
+				++archetype_modifications;
+			}
 		}
 
 		/**
@@ -802,18 +2665,46 @@ namespace ecs {
 		template<typename... Tcomponents>
 		void make_monotonic() {
 			[&, this]<std::size_t... I>(std::index_sequence<I...>) {
-				(MonotonicOp<detail::nth_type<I, Tcomponents...>>{}(*this, *get_storage<detail::nth_type<I, Tcomponents...>>()) && ...);
+				(MonotonicOp<detail::nth_type<I, Tcomponents...>>{}(*this) && ...);
 			}(std::make_index_sequence<sizeof...(Tcomponents)>{});
 		}
 		template<typename Tcomponent, size_t Unique = 0>
-		void make_monotonic() {
-			get_storage<Tcomponent, Unique>()->template sort_monotonic<Tcomponent, Unique>(*this);
+		void make_monotonic() { MonotonicOp<Tcomponent, Unique>{}(*this); }
+
+		/**
+		 * @brief Removes every component not owned by an entity and sorts every storage (and archetype table) by entity
+		 * @note Storages of positional components (such as hashtables) are left untouched
+		 * @note Moves most components, thus invalidates all outstanding references
+		 */
+		void compact() {
+			for(auto& storage: storages)
+				if(!storage.positional) storage.compact();
+			sort_archetypes_by_entity();
 		}
 	protected:
-		template<typename Tcomponent>
+		/**
+		 * @brief Sorts the rows of the archetype tables (optionally only those storing a component) by entity
+		 */
+		void sort_archetypes_by_entity(size_t component_id = component_storage::invalid) {
+			for(auto& table: archetypes) {
+				if(component_id != component_storage::invalid && !table.contains(component_id)) continue;
+				table.sort_by_entity();
+				for(size_t row = 0; row < table.size(); ++row)
+					entity_locations[table.entities[row]].row = row;
+			}
+		}
+
+		template<typename Tcomponent, size_t Unique = 0>
 		struct MonotonicOp {
-			inline bool operator()(scene& scene, component_storage& storage) const {
-				storage.sort_monotonic<Tcomponent>(scene);
+			inline bool operator()(scene& self) const {
+				if constexpr(detail::is_archetype_storable_v<Tcomponent>) if(self.mode == storage_mode::archetype) {
+					self.sort_archetypes_by_entity(get_global_component_id<Tcomponent, Unique>());
+					return true;
+				}
+				auto& storage = *self.get_storage<Tcomponent, Unique>();
+				// Positional storages keep their unowned elements (they are still meaningful), thus need a real sort
+				if(storage.positional) storage.template sort_monotonic<Tcomponent, Unique>(self);
+				else storage.compact();
 				return true;
 			}
 		};
@@ -822,23 +2713,17 @@ namespace ecs {
 	namespace detail {
 		// Gets the entity associated with a specific component index
 		inline entity get_entity(scene& scene, size_t index, size_t component_id) {
-			for(size_t e = 0; e < scene.entity_component_indices.size(); ++e)
-				if(scene.entity_component_indices[e].size() >= component_id && scene.entity_component_indices[e][component_id] == index)
-					return e;
-			return invalid_entity;
+			if(component_id >= scene.storages.size()) return invalid_entity;
+			return scene.storages[component_id].entity_of(index);
 		}
 		template<typename Tcomponent, size_t Unique = 0>
 		inline entity get_entity(scene& scene, size_t index) {
 			return get_entity(scene, index, get_global_component_id<Tcomponent, Unique>());
 		}
 
-		template<typename Tcomponent, size_t Unique = 0>
-		inline entity get_entity(scene::component_storage& storage, scene& scene, size_t index, std::optional<size_t> component_id = {}) {
-			if constexpr(detail::is_with_entity_v<Tcomponent>)
-				return ((Tcomponent*)(storage.data.data() + index * storage.element_size))->entity;
-			else if constexpr(std::is_same_v<Tcomponent, detail::void_like>)
-				return get_entity(scene, index, component_id.value());
-			else return get_entity<Tcomponent, Unique>(scene, index);
+		// NOTE: The storage's dense back-map is authoritative, so this lookup is constant time regardless of the component type
+		inline entity get_entity(const scene::component_storage& storage, size_t index) {
+			return storage.entity_of(index);
 		}
 	}
 
@@ -854,11 +2739,10 @@ namespace ecs {
 	* @return false if an error occurred, true otherwise
 	*/
 	template<typename Tcomponent, size_t Unique = 0>
-	inline bool swap_impl(scene::component_storage* self, struct scene& scene, size_t a, std::optional<size_t> _b = {}, bool swap_if_one_elementless = false, std::optional<size_t> _component_id = {}, optional_reference<std::vector<std::byte>> buffer = {}) {
+	inline bool swap_impl(scene::component_storage* self, struct scene&, size_t a, std::optional<size_t> _b = {}, bool swap_if_one_elementless = false, std::optional<size_t> = {}, optional_reference<std::vector<std::byte>> buffer = {}) {
 		size_t b = _b.value_or(self->size() - 1);
-		size_t component_id = _component_id.value_or(get_global_component_id<Tcomponent, Unique>());
-		entity eA = detail::get_entity<Tcomponent, Unique>(*self, scene, a, component_id);
-		entity eB = detail::get_entity<Tcomponent, Unique>(*self, scene, b, component_id);
+		entity eA = detail::get_entity(*self, a);
+		entity eB = detail::get_entity(*self, b);
 		if (swap_if_one_elementless) {
 			if (eA == invalid_entity && eB == invalid_entity) return false;
 		}
@@ -869,14 +2753,9 @@ namespace ecs {
 				if (!self->swap(a, b, *buffer)) return false;
 			} else if (!self->swap(a, b)) return false;
 		} else if (!self->swap<Tcomponent>(a, b)) return false;
-		if (swap_if_one_elementless && eA == invalid_entity)
-			scene.entity_component_indices[eB][component_id] = a;
-		else if (swap_if_one_elementless && eB == invalid_entity)
-			scene.entity_component_indices[eA][component_id] = b;
-		else std::swap(
-			scene.entity_component_indices[eA][component_id],
-			scene.entity_component_indices[eB][component_id]
-		);
+		std::swap(self->entities[a], self->entities[b]);
+		if (eA != invalid_entity) self->set_index(eA, b);
+		if (eB != invalid_entity) self->set_index(eB, a);
 		return true;
 	}
 	template<typename Tcomponent, size_t Unique /*= 0*/>
@@ -889,29 +2768,36 @@ namespace ecs {
 
 	/**
 	* @brief Function which removes the value associated with the provided entity
-	* @note performs a swap with the last stored value thus needs to update offset information stored in the scene
+	* @note destroys the removed value and relocates the last stored value into its slot, the dense back-map lets us patch its owner's index in constant time
 	*
 	* @param scene The scene storing offset information
 	* @param e The entity to remove
 	* @param component_id The component id to remove if a type is not automatically provided!
 	* @return true if the element was successfully removed, false if an error occurred
 	*/
-	inline bool scene::component_storage::remove(scene& scene, entity e, size_t component_id) {\
-		size_t size = this->size();
-		if(size == 0 || e >= scene.entity_component_indices.size()) return false;
-
-		auto& indices = scene.entity_component_indices[e];
-		if(indices.size() <= component_id) return false;
-
-		for(e = 0; e < scene.entity_component_indices.size(); ++e)
-			if( scene.entity_component_indices[e][component_id] == size - 1)
-				break;
-		if(e >= scene.entity_component_indices.size()) return false;
-
-		if(!swap(indices[component_id])) return false;
-		std::swap(indices[component_id], scene.entity_component_indices[e][component_id]);
-		data.erase(data.cbegin() + data.size() - element_size, data.cend());
-		indices[component_id] = invalid;
+	inline bool scene::component_storage::remove(scene& scene, entity e, size_t component_id) {
+		size_t index = index_of(e);
+		if(index == invalid) return false;
+
+		// Move the last element into the hole (no need to preserve the removed element, so no swap buffer is required)
+		size_t last = size() - 1;
+		adapter.dirty = true; ++modifications;
+		if(operations->destroy) operations->destroy(element(index));
+		if(index != last) {
+			relocate(element(index), element(last));
+			entity moved = entities[last];
+			entities[index] = moved;
+			if(moved != invalid_entity) set_index(moved, index);
+		}
+		if(is_contiguous()) data.erase(data.cbegin() + last * element_size, data.cend());
+		// Keep one spare page around so that adding and removing at a page boundary doesn't thrash the allocator
+		else if(pages.size() * elements_per_page >= last + 2 * elements_per_page) {
+			preserve(pages.size() - 1);
+			pages.pop_back();
+		}
+		entities.pop_back();
+		set_index(e, invalid);
+		scene.update_signature(e, component_id, false);
 		return true;
 	}
 
@@ -923,28 +2809,14 @@ namespace ecs {
 	* @param scene The scene where book keeping information about entities is stored
 	* @param component_id Id associated with the elements stored in this component (needed if Tcomponent not provided)
 	* @param order A list storing which index in the current order should be in the resulting order
-	* @note Only swaps are performed, so every element in order must be unique
-	* @note The order generated by std::iota results in no swaps being performed
+	* @note Every element in order must be unique
+	* @note Elements are gathered into freshly allocated memory, so all outstanding references are invalidated
 	*/
 	template<typename Tcomponent, size_t Unique = 0>
-	inline void reorder_impl(scene::component_storage* self, struct scene& scene, std::span<size_t> order, std::optional<size_t> _component_id = {}) {
+	inline void reorder_impl(scene::component_storage* self, struct scene&, std::span<size_t> order, std::optional<size_t> = {}) {
 		assert(order.size() == self->size()); // Require order to have an entry for every element in the array
-		size_t component_id = _component_id.value_or(get_global_component_id<Tcomponent, Unique>());
-
-		std::vector<size_t> swaps(order.size(), 0);
-		// Transpose the order (it now stores what needs to be swapped with what)
-		for(size_t i = 0; i < order.size(); i++)
-			swaps[order[i]] = i;
-
-		// Update the data storage and book keeping
-		std::vector<std::byte> swapBuffer(self->element_size, {});
-		for(size_t i = 0; i < swaps.size(); ++i)
-			while(swaps[i] != i) {
-				if constexpr(std::is_same_v<Tcomponent, detail::void_like>)
-					self->swap(scene, component_id, swaps[i], i, swapBuffer);
-				else self->swap<Tcomponent, Unique>(scene, swaps[i], i);
-				std::swap(swaps[swaps[i]], swaps[i]);
-			}
+		// Gather the elements into their new positions (one relocation per element, rather than a chain of swaps)
+		self->gather(order);
 	}
 	inline void scene::component_storage::reorder(struct scene& scene, size_t component_id, std::span<size_t> order) {
 		reorder_impl<detail::void_like, 0>(this, scene, order, component_id);
@@ -977,20 +2849,18 @@ namespace ecs {
 
 		// Sort the list of indices into the correct order (possibly alongside a list of entities)
 		if constexpr(with_entities) {
-			std::vector<entity> entities; entities.resize(size);
-			for(size_t i = size; i--; )
-				entities[i] = detail::get_entity<Tcomponent, Unique>(*self, scene, i, component_id);
+			std::vector<entity> entities(self->entities.begin(), self->entities.end()); // Copy since the reorder will update the back-map
 
 			auto comparator = [self, &entities, &_comparator](size_t _a, size_t _b) {
-				void* a = self->data.data() + _a * self->element_size;
-				void* b = self->data.data() + _b * self->element_size;
+				void* a = self->element(_a);
+				void* b = self->element(_b);
 				return _comparator(a, entities[_a], b, entities[_b]);
 			};
 			std::sort(order.begin(), order.end(), comparator);
 		} else {
 			auto comparator = [self, &_comparator](size_t _a, size_t _b) {
-				void* a = self->data.data() + _a * self->element_size;
-				void* b = self->data.data() + _b * self->element_size;
+				void* a = self->element(_a);
+				void* b = self->element(_b);
 				return _comparator(a, b);
 			};
 			std::sort(order.begin(), order.end(), comparator);
@@ -1019,6 +2889,111 @@ namespace ecs {
 		}
 	}
 
+	namespace detail {
+		template<typename T>
+		concept radix_sortable = std::integral<T> || std::is_enum_v<T> || (std::floating_point<T> && (sizeof(T) == 4 || sizeof(T) == 8));
+
+		/**
+		* @brief Maps a key to an unsigned integer which sorts in the same order
+		*/
+		template<radix_sortable T>
+		inline auto radix_key(T key) {
+			if constexpr(std::is_enum_v<T>) return radix_key(static_cast<std::underlying_type_t<T>>(key));
+			else if constexpr(std::same_as<T, bool>) return uint8_t(key); // bool has no unsigned counterpart
+			else if constexpr(std::floating_point<T>) {
+				using U = std::conditional_t<sizeof(T) == 4, uint32_t, uint64_t>;
+				constexpr U sign = U(1) << (sizeof(U) * 8 - 1);
+				U bits = std::bit_cast<U>(key);
+				return U(bits & sign ? ~bits : bits | sign); // Negative numbers sort in reverse, and before positive numbers
+			} else {
+				using U = std::make_unsigned_t<T>;
+				if constexpr(std::is_signed_v<T>) return U(U(key) ^ (U(1) << (sizeof(U) * 8 - 1)));
+				else return U(key);
+			}
+		}
+
+		/**
+		* @brief Stable LSD radix sort of (key, index) pairs
+		*
+		* @return The indices in sorted order
+		* @note Passes where every key has the same digit (such as the high bytes of entities) are skipped
+		*/
+		template<std::unsigned_integral Key>
+		std::vector<size_t> radix_sort_indices(std::vector<std::pair<Key, size_t>> items) {
+			std::vector<std::pair<Key, size_t>> scratch(items.size());
+			for(size_t shift = 0; shift < sizeof(Key) * 8; shift += 8) {
+				std::array<size_t, 256> offsets = {};
+				for(auto& item: items) ++offsets[(item.first >> shift) & 0xFF];
+				if(std::find(offsets.begin(), offsets.end(), items.size()) != offsets.end()) continue;
+
+				for(size_t digit = 0, total = 0; digit < offsets.size(); ++digit)
+					total += std::exchange(offsets[digit], total);
+				for(auto& item: items)
+					scratch[offsets[(item.first >> shift) & 0xFF]++] = item;
+				items.swap(scratch);
+			}
+
+			std::vector<size_t> order(items.size());
+			for(size_t i = 0; i < items.size(); ++i)
+				order[i] = items[i].second;
+			return order;
+		}
+
+		/**
+		* @brief Stable merge sort of a list of indices, large lists are split into runs which are sorted (then merged) on separate threads
+		*/
+		template<typename Less>
+		void parallel_sort_indices(std::vector<size_t>& order, const Less& less, size_t thread_count = std::thread::hardware_concurrency()) {
+			if(thread_count <= 1 || order.size() < ECS_PARALLEL_SORT_THRESHOLD)
+				return std::stable_sort(order.begin(), order.end(), less);
+
+			size_t runs = std::bit_floor(thread_count), per_run = (order.size() + runs - 1) / runs; // A power of two number of runs merges evenly
+			auto bound = [&](size_t run) { return order.begin() + std::min(run * per_run, order.size()); };
+			{
+				std::vector<std::jthread> threads;
+				for(size_t run = 0; run < runs; ++run)
+					threads.emplace_back([&, run] { std::stable_sort(bound(run), bound(run + 1), less); });
+			}
+			for(size_t width = 1; width < runs; width *= 2) {
+				std::vector<std::jthread> threads;
+				for(size_t run = 0; run + width < runs; run += 2 * width)
+					threads.emplace_back([&, run, width] { std::inplace_merge(bound(run), bound(run + width), bound(std::min(run + 2 * width, runs)), less); });
+			}
+		}
+	}
+
+	template<typename Tcomponent, size_t Unique /*= 0*/, typename KeyFn>
+	void scene::component_storage::sort_by_key(struct scene& scene, const KeyFn& extract) {
+		using Result = std::invoke_result_t<const KeyFn&, const Tcomponent&, entity>;
+		using Key = std::remove_cvref_t<Result>;
+		size_t size = this->size();
+		auto key_of = [&](size_t i) -> Result { return extract(*(const Tcomponent*)element(i), entities[i]); };
+
+		std::vector<size_t> order;
+		if constexpr(detail::radix_sortable<Key>) {
+			std::vector<std::pair<decltype(detail::radix_key(Key{})), size_t>> items(size);
+			for(size_t i = 0; i < size; ++i)
+				items[i] = {detail::radix_key(key_of(i)), i};
+			order = detail::radix_sort_indices(std::move(items));
+		} else {
+			// Extract the keys up front (or pointers to them) so comparisons don't need to find the elements again
+			using Stored = std::conditional_t<std::is_lvalue_reference_v<Result>, const Key*, Key>;
+			std::vector<Stored> keys; keys.reserve(size);
+			for(size_t i = 0; i < size; ++i)
+				if constexpr(std::is_pointer_v<Stored>) keys.push_back(&key_of(i));
+				else keys.push_back(key_of(i));
+			auto deref = [](const Stored& key) -> const Key& {
+				if constexpr(std::is_pointer_v<Stored>) return *key;
+				else return key;
+			};
+
+			order.resize(size);
+			std::iota(order.begin(), order.end(), 0);
+			detail::parallel_sort_indices(order, [&](size_t a, size_t b) { return std::less<Key>{}(deref(keys[a]), deref(keys[b])); });
+		}
+		reorder<Tcomponent, Unique>(scene, order);
+	}
+
 	// template<typename Tcomponent>
 	// inline void collect_garbage_impl(scene::component_storage* self, struct scene& scene, bool make_monotonic, optional<size_t> _component_id = {}) {
 	// 	size_t component_id = _component_id.value_or(get_global_component_id<Tcomponent>());
@@ -1026,7 +3001,7 @@ namespace ecs {
 
 	// 	std::vector<entity> entities; entities.resize(size);
 	// 	for(size_t i = size; i--; )
-	// 		entities[i] = detail::get_entity<Tcomponent>(*self, scene, i, component_id);
+	// 		entities[i] = detail::get_entity(*self, i);
 
 	// 	// Split the components into a referenced and unreferenced part
 	// 	std::vector<size_t> order; order.reserve(size);
@@ -27,7 +27,12 @@
 #define __ECS_QUERY_HPP__
 
 #include "ecs.hpp"
+#include <atomic>
+#include <exception>
+#include <mutex>
 #include <ranges>
+#include <system_error>
+#include <thread>
 #include <variant>
 
 /**
@@ -36,6 +41,10 @@
 */
 
 namespace ecs {
+#ifndef ECS_PARALLEL_CHUNK_SIZE
+	#define ECS_PARALLEL_CHUNK_SIZE 1024
+#endif
+
 	/**
 	* @brief Marker class which marks an entity as valid in the filter if any of the provided components are present.
 	*
@@ -221,6 +230,84 @@ namespace ecs {
 		*/
 		template<typename T>
 		using or_to_tuple_t = typename or_to_tuple<T>::type;
+
+		/**
+		* @struct validity_from_archetype
+		* @tparam T The type to check
+		* @brief A template struct that checks if an archetype alone determines if a type matches (true for archetype storable components and optionals).
+		*/
+		template<typename T>
+		struct validity_from_archetype : public is_archetype_storable<T> {};
+		template<typename T>
+		struct validity_from_archetype<optional<T>> : public std::true_type {};
+		template<typename... Ts>
+		struct validity_from_archetype<or_<Ts...>> : public std::bool_constant<(validity_from_archetype<Ts>::value && ...)> {};
+
+		/**
+		* @variable validity_from_archetype_v
+		* @brief A static variable that contains the result of a call to the validity_from_archetype struct.
+		*/
+		template<typename T>
+		static constexpr bool validity_from_archetype_v = validity_from_archetype<T>::value;
+
+		/**
+		* @brief Ensures that the global ids of every component referenced by a query have been assigned.
+		* @note Called before spawning worker threads so that they only ever read the component registry
+		*/
+		template<typename T>
+		struct register_component_ids { static void run() { get_global_component_id<T>(); } };
+		template<typename T>
+		struct register_component_ids<optional<T>> { static void run() { register_component_ids<T>::run(); } };
+		template<typename... Ts>
+		struct register_component_ids<or_<Ts...>> { static void run() { (register_component_ids<Ts>::run(), ...); } };
+
+		/**
+		* @brief Splits the range [0, count) into chunks and processes them on several threads.
+		*
+		* Threads (including the calling thread) repeatedly claim the next unprocessed chunk until the range is exhausted,
+		*  so threads which finish early pick up the remaining work.
+		* If process throws, no further chunks are handed out and the first exception is rethrown on the calling thread once every worker has stopped.
+		*
+		* @param count The number of elements in the range.
+		* @param chunk_size The number of elements claimed at once.
+		* @param thread_count The maximum number of threads to use (including the calling thread).
+		* @param process Function called with the beginning and end of each chunk.
+		*/
+		template<typename F>
+		void parallel_chunks(size_t count, size_t chunk_size, size_t thread_count, const F& process) {
+			if(chunk_size == 0) chunk_size = 1;
+			size_t chunk_count = (count + chunk_size - 1) / chunk_size;
+			thread_count = std::min(std::max<size_t>(thread_count, 1), chunk_count);
+			if(thread_count <= 1) {
+				if(count) process(0, count);
+				return;
+			}
+
+			std::atomic<size_t> next = 0;
+			std::exception_ptr failure;
+			std::mutex failure_mutex;
+			auto worker = [&] {
+				try {
+					for(size_t begin; (begin = next.fetch_add(chunk_size, std::memory_order_relaxed)) < count; )
+						process(begin, std::min(begin + chunk_size, count));
+				} catch(...) {
+					next.store(count, std::memory_order_relaxed); // Stop handing out chunks
+					std::scoped_lock lock(failure_mutex);
+					if(!failure) failure = std::current_exception();
+				}
+			};
+
+			std::vector<std::thread> threads;
+			threads.reserve(thread_count - 1);
+			try {
+				for(size_t i = 1; i < thread_count; ++i)
+					threads.emplace_back(worker);
+			} catch(const std::system_error&) {} // Carry on with however many threads could be started
+			worker();
+			for(auto& thread: threads)
+				thread.join();
+			if(failure) std::rethrow_exception(failure);
+		}
 	}
 
 
@@ -229,6 +316,13 @@ namespace ecs {
 	* @brief A class that provides a view into an ECS (Entity-Component-System) scene.
 	*
 	* This class is used to iterate over entities in a scene and access their components.
+	*
+	* @note Iteration is driven by the dense list of the smallest storage of a required component, so entities are visited in the order their elements
+	*	were added to it (or the order compact, reorder_entities, or sort_by_entity left them in) rather than by entity id. In archetype mode entities
+	*	are visited table by table, and views of only optional components (or ors) visit every entity in id order.
+	* @note The current entity's components may be removed while iterating. Removing another entity's element from the driving storage moves the
+	*	storage's last element into its slot, so an element which hasn't been visited yet may be skipped (and in archetype mode adding or removing
+	*	any component moves the entity between tables, so it may be skipped or visited again).
 	*/
 	template<typename... Tcomponents>
 	struct scene_view {
@@ -277,6 +371,16 @@ namespace ecs {
 			*/
 			ecs::scene* scene;
 			entity e;
+			/**
+			* The archetype table and row the iterator is currently pointing at (only used when iterating a scene in archetype mode)
+			*/
+			size_t archetype = 0, row = 0;
+			/**
+			* The component storage driving the iteration (the smallest storage of a required component) and the current index into its dense entity list
+			* @note When no storage drives the iteration every entity in the scene is visited
+			*/
+			size_t driver = no_driver, dense = 0;
+			static constexpr size_t no_driver = std::numeric_limits<size_t>::max();
 
 			/**
 			* Checks if the iterator is valid.
@@ -285,7 +389,112 @@ namespace ecs {
 			*/
 			bool valid() const { return (valid_impl<Tcomponents>() && ...); }
 
+			/**
+			* Checks if every entity stored in an archetype could match this view.
+			*
+			* @param table The archetype to check.
+			* @return True if the archetype matches, false otherwise.
+			*/
+			bool archetype_matches(const scene::archetype& table) const { return (archetype_matches_impl<Tcomponents>(table) && ...); }
+
+			/**
+			* Weather or not this iterator walks the archetype tables rather than every entity.
+			* @note Views consisting only of optional components must visit every entity, so they never walk the archetype tables
+			*/
+			bool walks_archetypes() const { return scene->mode == storage_mode::archetype && has_required_component; }
+
+			/**
+			* Positions the iterator on the first valid entity.
+			*/
+			void seek_first() {
+				if(!walks_archetypes()) {
+					driver = no_driver;
+					if constexpr(has_driving_component) {
+						size_t smallest = std::numeric_limits<size_t>::max();
+						(select_driver<Tcomponents>(smallest), ...);
+						dense = 0;
+						if(driver_done()) return;
+						e = scene->storages[driver].entities[dense];
+						if(!driver_owns(dense, e) || !valid()) ++*this;
+						return;
+					}
+					if(!valid()) ++*this;
+					return;
+				}
+
+				archetype = 0; row = 0;
+				while(archetype < scene->archetypes.size() && (scene->archetypes[archetype].size() == 0 || !archetype_matches(scene->archetypes[archetype])))
+					++archetype;
+				if(archetype < scene->archetypes.size()) {
+					e = scene->archetypes[archetype].entities[row];
+					if(!all_archetype_storable && !valid()) ++*this;
+				}
+			}
+
 		protected:
+			/**
+			* Weather or not any of the components being queried are required (not optional)
+			*/
+			static constexpr bool has_required_component = (!detail::is_optional_v<Tcomponents> || ...);
+			/**
+			* Weather or not all of the required components are stored in archetype tables (if they are validity is fully determined by the archetype)
+			*/
+			static constexpr bool all_archetype_storable = (detail::validity_from_archetype_v<Tcomponents> && ...);
+			/**
+			* Weather or not any of the components being queried is required on its own (not optional or part of an or_), and thus can drive iteration from its storage
+			*/
+			static constexpr bool has_driving_component = ((!detail::is_optional_v<Tcomponents> && !detail::is_or_v<Tcomponents>) || ...);
+
+			/**
+			* A template function that makes the provided component's storage drive the iteration if it is smaller than the current driver.
+			*
+			* @param Tcomponent The component type to consider.
+			* @param smallest The size of the current driver (updated if this component's storage becomes the driver).
+			*/
+			template<typename Tcomponent>
+			void select_driver(size_t& smallest) {
+				if constexpr(!detail::is_optional_v<Tcomponent> && !detail::is_or_v<Tcomponent>) {
+					size_t id = get_global_component_id<Tcomponent>();
+					size_t size = id < scene->storages.size() ? scene->storages[id].entities.size() : 0;
+					if(size < smallest) {
+						driver = id;
+						smallest = size;
+					}
+				}
+			}
+
+			/**
+			* Checks if the element at an index of the driving storage is owned by an entity.
+			* @note Unowned elements have an invalid entity in the dense list, the sparse index is also checked so that a stale entry is never visited
+			*/
+			bool driver_owns(size_t index, entity e) const { return e != invalid_entity && scene->storages[driver].index_of(e) == index; }
+
+			/**
+			* Checks if the driving storage has been exhausted.
+			*/
+			bool driver_done() const {
+				return driver >= scene->storages.size() || dense >= scene->storages[driver].entities.size();
+			}
+
+			/**
+			* A template function that checks if an archetype could match for a single component type.
+			*
+			* @param Tcomponent The component type to check.
+			* @param table The archetype to check.
+			* @return True if the component is present in the archetype (or is not archetype storable), false otherwise.
+			*/
+			template<typename Tcomponent>
+			bool archetype_matches_impl(const scene::archetype& table) const {
+				if constexpr(detail::is_or_v<Tcomponent>) {
+					return archetype_matches_or_expand(table, Tcomponent{});
+				} else if constexpr(detail::is_optional_v<Tcomponent> || !detail::is_archetype_storable_v<Tcomponent>) {
+					return true;
+				} else
+					return table.contains(get_global_component_id<Tcomponent>());
+			}
+			template<typename... Tcomps>
+			bool archetype_matches_or_expand(const scene::archetype& table, or_<Tcomps...>) const { return (archetype_matches_impl<Tcomps>(table) || ...); }
+
 			/**
 			* A template function that checks if the iterator is valid for a single component type.
 			*
@@ -319,7 +528,12 @@ namespace ecs {
 			* @param Sentinel The sentinel value to compare with.
 			* @return True if the iterators are equal, false otherwise.
 			*/
-			bool operator==(Sentinel) const { return scene == nullptr || e >= scene->size<true>(); }
+			bool operator==(Sentinel) const {
+				if(scene == nullptr) return true;
+				if(walks_archetypes()) return archetype >= scene->archetypes.size();
+				if(driver != no_driver) return driver_done();
+				return e >= scene->size<true>();
+			}
 
 			/**
 			* Compares two iterators for ordering.
@@ -340,7 +554,7 @@ namespace ecs {
 			* @return The old state of the iterator before incrementation.
 			*/
 			Iterator operator++(detail::post_increment_t) {
-				Iterator old{scene, e};
+				Iterator old = *this;
 				operator++();
 				return old;
 			}
@@ -351,6 +565,34 @@ namespace ecs {
 			* @return This iterator after incrementation.
 			*/
 			Iterator& operator++() {
+				if(walks_archetypes()) {
+					// Walk the rows of every matching archetype linearly
+					auto& archetypes = scene->archetypes;
+					do {
+						if(++row >= archetypes[archetype].size()) {
+							row = 0;
+							do {
+								++archetype;
+							} while(archetype < archetypes.size() && (archetypes[archetype].size() == 0 || !archetype_matches(archetypes[archetype])));
+							if(archetype >= archetypes.size()) return *this;
+						}
+						e = archetypes[archetype].entities[row];
+					} while(!all_archetype_storable && !valid());
+					return *this;
+				}
+
+				if(driver != no_driver) {
+					// Walk the dense entity list of the smallest storage, only probing the other storages
+					auto& storage = scene->storages[driver];
+					// If the current entity's element was removed the last element was moved into its slot, and still needs to be visited
+					if(dense < storage.entities.size() && storage.entities[dense] == e) ++dense;
+					for(; dense < storage.entities.size(); ++dense) {
+						e = storage.entities[dense];
+						if(driver_owns(dense, e) && valid()) break;
+					}
+					return *this;
+				}
+
 				do {
 					e++;
 				} while(!valid() && e < scene->size<true>());
@@ -364,6 +606,59 @@ namespace ecs {
 			*/
 			reference operator*() const { return { get_component<Tcomponents, true>()... }; }
 
+			/**
+			* Calls a function on every entity matched by an iterator using several threads.
+			*
+			* @param first An iterator positioned at the start of the view (determines which storage drives iteration and how results are dereferenced).
+			* @param f The function to call with the dereferenced iterator.
+			* @param chunk_size The number of entities each thread claims at once.
+			* @param thread_count The maximum number of threads to use.
+			* @note One set of worker threads is started per call (and shared by every matching archetype table), exceptions thrown by f are rethrown on the calling thread
+			*/
+			template<typename Self, typename F>
+			static void parallel_for_each(const Self& first, const F& f, size_t chunk_size, size_t thread_count) {
+				ecs::scene& scene = *first.scene;
+				if(first.walks_archetypes()) {
+					// Every matching table's rows are laid end to end so that one set of workers covers them all, tables[i] starts at offsets[i]
+					std::vector<size_t> tables, offsets;
+					size_t total = 0;
+					for(size_t a = 0; a < scene.archetypes.size(); ++a)
+						if(scene.archetypes[a].size() && first.archetype_matches(scene.archetypes[a])) {
+							tables.push_back(a);
+							offsets.push_back(total);
+							total += scene.archetypes[a].size();
+						}
+					detail::parallel_chunks(total, chunk_size, thread_count, [&](size_t begin, size_t end) {
+						Self it = first;
+						// A chunk may span the end of one table and the start of the next
+						for(size_t i = std::ranges::upper_bound(offsets, begin) - offsets.begin() - 1; begin < end; ++i) {
+							auto& table = scene.archetypes[tables[i]];
+							size_t stop = std::min(end, offsets[i] + table.size());
+							it.archetype = tables[i];
+							for(it.row = begin - offsets[i]; it.row < stop - offsets[i]; ++it.row) {
+								it.e = table.entities[it.row];
+								if(all_archetype_storable || it.valid()) f(*it);
+							}
+							begin = stop;
+						}
+					});
+				} else if(first.driver != no_driver) {
+					if(first.driver >= scene.storages.size()) return;
+					auto& entities = scene.storages[first.driver].entities;
+					detail::parallel_chunks(entities.size(), chunk_size, thread_count, [&](size_t begin, size_t end) {
+						Self it = first;
+						for(it.dense = begin; it.dense < end; ++it.dense) {
+							it.e = entities[it.dense];
+							if(it.driver_owns(it.dense, it.e) && it.valid()) f(*it);
+						}
+					});
+				} else detail::parallel_chunks(scene.size<true>(), chunk_size, thread_count, [&](size_t begin, size_t end) {
+					Self it = first;
+					for(it.e = begin; it.e < end; ++it.e)
+						if(it.valid()) f(*it);
+				});
+			}
+
 		protected:
 			/**
 			* @brief Get a component from the scene.
@@ -379,8 +674,25 @@ namespace ecs {
 				else if constexpr(detail::is_optional_v<Tcomponent>)
 					return get_component_optional(Tcomponent{});
 				else if constexpr(deref)
-					return *scene->get_component<Tcomponent>(e);
-				else return scene->get_component<Tcomponent>(e);
+					return *get_component_direct<Tcomponent>();
+				else return get_component_direct<Tcomponent>();
+			}
+
+			/**
+			* @brief Get a component, reading it straight out of the current archetype's column when possible.
+			*
+			* @tparam Tcomponent The type of the component to retrieve.
+			* @return An optional reference to the component.
+			*/
+			template<typename Tcomponent>
+			inline optional_reference<Tcomponent> get_component_direct() const {
+				if constexpr(detail::is_archetype_storable_v<Tcomponent>) if(walks_archetypes()) {
+					auto& table = scene->archetypes[archetype];
+					size_t column = table.column_of(get_global_component_id<Tcomponent>());
+					if(column == scene::archetype::invalid) return {};
+					return {*(Tcomponent*)table.get(column, row)};
+				}
+				return scene->get_component<Tcomponent>(e);
 			}
 
 			/**
@@ -414,7 +726,7 @@ namespace ecs {
 			*/
 			template<typename Tcomponent>
 			inline optional_reference<Tcomponent> get_component_optional(std::optional<Tcomponent>) const {
-				return scene->get_component<Tcomponent>(e);
+				return get_component_direct<Tcomponent>();
 			}
 		};
 
@@ -425,13 +737,28 @@ namespace ecs {
 		*/
 		Iterator begin() {
 			Iterator out{&scene, 0};
-			if(!out.valid()) ++out;
+			out.seek_first();
 			return out;
 		}
 		/**
 		* @brief Marks the end of an iteration over the matching entities in the scene.
 		*/
 		Sentinel end() { return {}; }
+
+		/**
+		* @brief Calls a function on every matching entity, splitting the work across several threads.
+		*
+		* @note The function may read any component and write to the components of the entity it was called with,
+		*  but must not add or remove components or entities while the iteration is in progress.
+		* @param f The function to call with the components of each matching entity (the same tuple as dereferencing an iterator).
+		* @param chunk_size The number of entities each thread claims at once.
+		* @param thread_count The maximum number of threads to use.
+		*/
+		template<typename F>
+		void par_for_each(const F& f, size_t chunk_size = ECS_PARALLEL_CHUNK_SIZE, size_t thread_count = std::thread::hardware_concurrency()) {
+			(detail::register_component_ids<Tcomponents>::run(), ...);
+			Iterator::parallel_for_each(begin(), f, chunk_size, thread_count);
+		}
 	};
 
 
@@ -448,16 +775,22 @@ namespace ecs {
 			using Base = scene_view<Tcomponents...>::Iterator;
 			using value_type = std::tuple<entity, detail::or_to_variant_t<Tcomponents>...>;
 			using reference = std::tuple<entity, detail::or_to_variant_reference_t<Tcomponents>...>;
-			Iterator operator++(detail::post_increment_t) { Iterator old{this->scene, this->e}; operator++(); return old; }
+			Iterator operator++(detail::post_increment_t) { Iterator old = *this; operator++(); return old; }
 			Iterator& operator++() { Base::operator++(); return *this; }
 			reference operator*() const { return { this->e, this->template get_component<Tcomponents, true>()... }; }
 		};
 
 		Iterator begin() {
 			Iterator out{&this->scene, 0};
-			if(!out.valid()) ++out;
+			out.seek_first();
 			return out;
 		}
+
+		template<typename F>
+		void par_for_each(const F& f, size_t chunk_size = ECS_PARALLEL_CHUNK_SIZE, size_t thread_count = std::thread::hardware_concurrency()) {
+			(detail::register_component_ids<Tcomponents>::run(), ...);
+			Iterator::parallel_for_each(begin(), f, chunk_size, thread_count);
+		}
 	};
 
 	/**
@@ -473,16 +806,22 @@ namespace ecs {
 			using Base = scene_view<Tcomponents...>::Iterator;
 			using value_type = std::tuple<scene&, detail::or_to_variant_t<Tcomponents>...>;
 			using reference = std::tuple<scene&, detail::or_to_variant_reference_t<Tcomponents>...>;
-			Iterator operator++(detail::post_increment_t) { Iterator old{this->scene, this->e}; operator++(); return old; }
+			Iterator operator++(detail::post_increment_t) { Iterator old = *this; operator++(); return old; }
 			Iterator& operator++() { Base::operator++(); return *this; }
 			reference operator*() const { return { this->scene, this->template get_component<Tcomponents, true>()... }; }
 		};
 
 		Iterator begin() {
 			Iterator out{&this->scene, 0};
-			if(!out.valid()) ++out;
+			out.seek_first();
 			return out;
 		}
+
+		template<typename F>
+		void par_for_each(const F& f, size_t chunk_size = ECS_PARALLEL_CHUNK_SIZE, size_t thread_count = std::thread::hardware_concurrency()) {
+			(detail::register_component_ids<Tcomponents>::run(), ...);
+			Iterator::parallel_for_each(begin(), f, chunk_size, thread_count);
+		}
 	};
 
 	template<typename... Tcomponents>
@@ -491,16 +830,22 @@ namespace ecs {
 			using Base = scene_view<Tcomponents...>::Iterator;
 			using value_type = std::tuple<scene&, entity, detail::or_to_variant_t<Tcomponents>...>;
 			using reference = std::tuple<scene&, entity, detail::or_to_variant_reference_t<Tcomponents>...>;
-			Iterator operator++(detail::post_increment_t) { Iterator old{this->scene, this->e}; operator++(); return old; }
+			Iterator operator++(detail::post_increment_t) { Iterator old = *this; operator++(); return old; }
 			Iterator& operator++() { Base::operator++(); return *this; }
 			reference operator*() const { return { this->scene, this->e, this->template get_component<Tcomponents, true>()... }; }
 		};
 
 		Iterator begin() {
 			Iterator out{&this->scene, 0};
-			if(!out.valid()) ++out;
+			out.seek_first();
 			return out;
 		}
+
+		template<typename F>
+		void par_for_each(const F& f, size_t chunk_size = ECS_PARALLEL_CHUNK_SIZE, size_t thread_count = std::thread::hardware_concurrency()) {
+			(detail::register_component_ids<Tcomponents>::run(), ...);
+			Iterator::parallel_for_each(begin(), f, chunk_size, thread_count);
+		}
 	};
 
 	template<typename... Tcomponents>
@@ -509,16 +854,22 @@ namespace ecs {
 			using Base = scene_view<Tcomponents...>::Iterator;
 			using value_type = std::tuple<entity, scene&, detail::or_to_variant_t<Tcomponents>...>;
 			using reference = std::tuple<entity, scene&, detail::or_to_variant_reference_t<Tcomponents>...>;
-			Iterator operator++(detail::post_increment_t) { Iterator old{this->scene, this->e}; operator++(); return old; }
+			Iterator operator++(detail::post_increment_t) { Iterator old = *this; operator++(); return old; }
 			Iterator& operator++() { Base::operator++(); return *this; }
 			reference operator*() const { return { this->e, this->scene, this->template get_component<Tcomponents, true>()... }; }
 		};
 
 		Iterator begin() {
 			Iterator out{&this->scene, 0};
-			if(!out.valid()) ++out;
+			out.seek_first();
 			return out;
 		}
+
+		template<typename F>
+		void par_for_each(const F& f, size_t chunk_size = ECS_PARALLEL_CHUNK_SIZE, size_t thread_count = std::thread::hardware_concurrency()) {
+			(detail::register_component_ids<Tcomponents>::run(), ...);
+			Iterator::parallel_for_each(begin(), f, chunk_size, thread_count);
+		}
 	};
 
 	/**
@@ -546,6 +897,19 @@ namespace ecs {
 		View v{scene};
 		return std::ranges::subrange<typename View::Iterator, typename View::Sentinel, std::ranges::subrange_kind::unsized>(v.begin(), v.end());
 	}
+
+	/**
+	* @brief Calls a function on every entity (and its components) that matches the given filter, splitting the work across several threads.
+	*
+	* @param scene The ECS scene to query.
+	* @param f The function to call with the components of each matching entity.
+	* @param chunk_size The number of entities each thread claims at once.
+	* @param thread_count The maximum number of threads to use.
+	*/
+	template<typename... Tcomponents, typename F>
+	void par_for_each(scene& scene, const F& f, size_t chunk_size = ECS_PARALLEL_CHUNK_SIZE, size_t thread_count = std::thread::hardware_concurrency()) {
+		scene_view<Tcomponents...>{scene}.par_for_each(f, chunk_size, thread_count);
+	}
 }
 
 #endif // __ECS_QUERY_HPP__
\ No newline at end of file
@@ -8,10 +8,17 @@
 #include "ECS/query.hpp"
 #include "ECS/adapter.hpp"
 #include "fnv1a.hpp"
+#include "wyhash.hpp"
 
 #include <nowide/iostream.hpp>
+#include <tracy/Tracy.hpp>
 #include <map>
 #include <deque>
+#include <memory>
+#include <memory_resource>
+#include <algorithm>
+#include <atomic>
+#include <unordered_map>
 
 namespace doir {
 	using ecs::optional_reference;
@@ -23,27 +30,237 @@ namespace doir {
 
 	static constexpr Token InvalidToken = ecs::invalid_entity;
 
+	// Dense id of an interned string (see Interner), two symbols from the same interner are equal exactly when their strings are
+	enum class SymbolId : uint32_t {};
+	static constexpr SymbolId InvalidSymbol = SymbolId(std::numeric_limits<uint32_t>::max());
+
 	template<typename T>
 	using hashtable_t = ecs::hashtable::component_storage<T>::component_type;
 
-	struct Module;
-#ifdef DOIR_IMPLEMENTATION
-	thread_local Module* hash_lookup_module;
+#ifdef DOIR_ARCHETYPE_STORAGE
+	static constexpr ecs::storage_mode default_storage_mode = ecs::storage_mode::archetype;
 #else
-	extern thread_local Module* hash_lookup_module;
+	static constexpr ecs::storage_mode default_storage_mode = ecs::storage_mode::sparse_set;
 #endif
 
-	struct Module: protected ecs::scene {
-		std::string buffer;
+	namespace detail {
+		// Owns the memory a module allocates from, as a base class so that it is constructed before (and destroyed after) the scene allocating from it
+		struct ModuleMemory {
+			std::unique_ptr<std::pmr::unsynchronized_pool_resource> pool;
+			std::pmr::memory_resource* memory;
+
+			ModuleMemory(std::pmr::memory_resource* resource)
+				: pool(resource ? nullptr : std::make_unique<std::pmr::unsynchronized_pool_resource>()), memory(resource ? resource : pool.get()) {}
+		};
+	}
+
+	/**
+	* @brief Maps strings to dense SymbolIds, so identifiers can be compared and hashed as integers
+	*
+	* @note Strings are never removed once interned (so rolling a module back to a snapshot keeps any symbols made since), views returned by name stay valid for the interner's lifetime
+	*/
+	struct Interner {
+		Interner(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) : strings(memory), ids(memory) {}
+		Interner(const Interner& o) : Interner(o.strings.get_allocator().resource()) { *this = o; }
+		Interner(Interner&&) = default; // Moving the deque keeps its strings in place, so the map's views stay valid
+		Interner& operator=(const Interner& o) {
+			if(this == &o) return *this;
+			strings.clear(); ids.clear();
+			for(auto& string: o.strings) intern(string); // The map's keys view our own strings, so they can't just be copied
+			return *this;
+		}
+		Interner& operator=(Interner&& o) {
+			if(strings.get_allocator() != o.strings.get_allocator()) return *this = o; // Strings from another resource would be moved one at a time (invalidating the views)
+			strings = std::move(o.strings);
+			ids = std::move(o.ids);
+			return *this;
+		}
+
+		// Returns the symbol for a string, adding it if this is the first time it has been seen
+		SymbolId intern(std::string_view string) {
+			if(auto found = ids.find(string); found != ids.end()) return found->second;
+			auto id = SymbolId(strings.size());
+			auto& stored = strings.emplace_back(string);
+			ids.emplace(std::string_view{stored}, id);
+			return id;
+		}
+		// Returns the symbol for a string without adding it
+		std::optional<SymbolId> find(std::string_view string) const {
+			if(auto found = ids.find(string); found != ids.end()) return found->second;
+			return {};
+		}
+		inline std::string_view name(SymbolId symbol) const { return strings[size_t(symbol)]; }
+		inline bool contains(SymbolId symbol) const { return size_t(symbol) < strings.size(); }
+		inline size_t size() const { return strings.size(); }
+
+	protected:
+		std::pmr::deque<std::pmr::string> strings; // A deque never moves its elements as it grows
+		std::pmr::unordered_map<std::string_view, SymbolId, wyhash::wyhash_64<std::string_view>> ids;
+	};
+
+	namespace detail {
+		struct IndexBase {
+			virtual ~IndexBase() = default;
+		};
+
+		inline std::atomic<size_t> next_index_id = 0;
+		template<typename Tindex>
+		size_t index_id() {
+			static size_t id = next_index_id++;
+			return id;
+		}
+	}
+
+	/**
+	* @brief A secondary index over an attribute, mapping a key extracted from each attribute to the tokens which own it
+	*
+	* @tparam Tattr The indexed attribute
+	* @tparam KeyOf Default constructible function object extracting the key from an attribute (keys must be ordered with < and hashable with Hash)
+	* @note Declared by asking a module for it (see Module::get_index), which also brings it up to date: attributes added since the last call are merged in,
+	*	and the index is rebuilt if any attributes were removed, moved, or renumbered (keys modified in place aren't noticed, just like with hashtables)
+	* @note Attributes stored in archetype tables are only tracked at the scene level, so their indices are rebuilt (in O(tokens + n log n)) whenever any token
+	*	gained or lost an archetype stored attribute, or was renumbered, since the last request
+	*/
+	template<typename Tattr, typename KeyOf, size_t Unique = 0, typename Hash = wyhash::wyhash_64<std::remove_cvref_t<std::invoke_result_t<KeyOf, const Tattr&>>>>
+	struct Index : public detail::IndexBase {
+		using attribute_type = Tattr;
+		using key_type = std::remove_cvref_t<std::invoke_result_t<KeyOf, const Tattr&>>;
+		struct Entry {
+			key_type key;
+			Token token;
+			bool operator<(const Entry& o) const {
+				if(key < o.key) return true;
+				if(o.key < key) return false;
+				return token < o.token;
+			}
+		};
+
+		Index(std::pmr::memory_resource* memory = std::pmr::get_default_resource()) : entries(memory), lookup(memory) {}
+
+		// Every token whose attribute has exactly this key (in token order), O(1)
+		std::span<const Entry> find(const key_type& key) const {
+			auto found = lookup.find(key);
+			if(found == lookup.end()) return {};
+			return {entries.data() + found->second.first, found->second.second};
+		}
+		optional<Token> find_first(const key_type& key) const {
+			auto found = find(key);
+			if(found.empty()) return {};
+			return found.front().token;
+		}
+		// Every token whose attribute's key lies in [first, last) (in key order), O(log n)
+		std::span<const Entry> range(const key_type& first, const key_type& last) const {
+			auto begin = std::ranges::lower_bound(entries, first, std::less<>{}, &Entry::key);
+			auto end = std::ranges::lower_bound(begin, entries.end(), last, std::less<>{}, &Entry::key);
+			return {begin, end};
+		}
+		// Every indexed token (in key order)
+		inline std::span<const Entry> all() const { return entries; }
+		inline size_t size() const { return entries.size(); }
+		inline bool empty() const { return entries.empty(); }
+
+		/**
+		* @brief Brings the index up to date with the attributes stored in the scene
+		* @note Called by Module::get_index, O(1) if nothing changed, O(k log k + n) if k attributes were added (only keys sorting after the first new one are looked up again), O(n log n) if they were moved or removed
+		*/
+		void update(const ecs::scene& scene) {
+			constexpr size_t unseen = std::numeric_limits<size_t>::max();
+			if(scene.mode == ecs::storage_mode::archetype && ecs::detail::is_archetype_storable_v<Tattr>) {
+				if(archetype_modifications == scene.archetype_modifications) return;
+				archetype_modifications = scene.archetype_modifications;
+				entries.clear();
+				for(Token t = 0; t < scene.size<true>(); ++t)
+					if(auto attr = scene.get_component<Tattr, Unique>(t); attr)
+						entries.push_back({KeyOf{}(*attr), t});
+				std::sort(entries.begin(), entries.end());
+				modifications = unseen;
+				return rebuild_lookup();
+			}
+
+			archetype_modifications = unseen;
+			auto storage = scene.get_storage<Tattr, Unique>();
+			if(!storage) {
+				entries.clear(); lookup.clear();
+				seen = 0; modifications = unseen;
+				return;
+			}
+			bool stale = storage->modifications != modifications || storage->size() < seen;
+			if(stale) {
+				entries.clear();
+				seen = 0;
+				modifications = storage->modifications;
+			} else if(seen == storage->size()) return;
+
+			// Only the elements appended since the last update need to be sorted, they are then merged with the already sorted entries
+			size_t merged = entries.size();
+			for(size_t i = seen, size = storage->size(); i < size; ++i)
+				if(Token t = storage->entity_of(i); t != InvalidToken && storage->index_of(t) == i)
+					entries.push_back({KeyOf{}(*(const Tattr*)storage->element(i)), t});
+			seen = storage->size();
+			if(entries.size() == merged) return stale ? rebuild_lookup() : void();
+			std::sort(entries.begin() + merged, entries.end());
+
+			// Runs whose keys sort before every new key keep their place, so only the runs from the first new key onward need to be looked up again
+			auto unmoved = std::ranges::lower_bound(entries.begin(), entries.begin() + merged, entries[merged].key, std::less<>{}, &Entry::key);
+			std::inplace_merge(entries.begin(), entries.begin() + merged, entries.end());
+			rebuild_lookup(unmoved - entries.begin());
+		}
+
+	protected:
+		std::pmr::vector<Entry> entries; // Sorted by key (then token)
+		std::pmr::unordered_map<key_type, std::pair<size_t, size_t>, Hash> lookup; // Where each key's run of entries starts, and how long it is
+		size_t seen = 0; // How many of the storage's elements have been indexed
+		size_t modifications = std::numeric_limits<size_t>::max(); // The storage's modification count when it was last indexed
+		size_t archetype_modifications = std::numeric_limits<size_t>::max(); // The scene's archetype modification count when it was last indexed (archetype storage only)
+
+		// Refreshes the runs of every entry from first onward (which must be the start of a run)
+		void rebuild_lookup(size_t first = 0) {
+			if(first == 0) lookup.clear();
+			std::pair<size_t, size_t>* run = nullptr;
+			for(size_t i = first; i < entries.size(); ++i) {
+				if(!run || entries[i - 1].key < entries[i].key)
+					run = &lookup.insert_or_assign(entries[i].key, std::pair<size_t, size_t>{i, 0}).first->second;
+				++run->second;
+			}
+		}
+	};
 
-		Module(const std::string& buffer = "") : buffer(buffer) {
+	// NOTE: By default every module allocates its tokens, attributes, and buffer from its own pool (so arrays freed by compaction, rehashing, and growth are reused),
+	//	modules which are compiled once can be given a std::pmr::monotonic_buffer_resource instead, which is faster but never frees anything until it is destroyed
+	struct Module: private detail::ModuleMemory, protected ecs::scene {
+		std::pmr::string buffer;
+		Interner symbols;
+
+		Module(const std::string& buffer = "", ecs::storage_mode mode = default_storage_mode, std::pmr::memory_resource* resource = nullptr)
+			: detail::ModuleMemory(resource), ecs::scene(memory), buffer(buffer, memory), symbols(memory), indices(memory) {
+			this->mode = mode;
 			volatile Token t = make_token(); // When not stored in a volatile the optimizer likes to get rid of this call!
 			assert(t == 0); // Reserve token 0 for errors!
 		}
 
 		inline size_t token_count() const { return size(); }
 
+		inline ecs::storage_mode storage_mode() const { return mode; }
+
+		// The memory resource the module (and any allocator aware attributes, such as std::pmr::string) allocates from
+		inline std::pmr::memory_resource* resource() const { return memory; }
+
+		// Interns a string (usually an identifier's lexeme) into the module's symbol table
+		inline SymbolId intern(std::string_view string) { return symbols.intern(string); }
+		inline std::string_view symbol_name(SymbolId symbol) const { return symbols.name(symbol); }
+
 		inline Token make_token() { return create_entity(); }
+		// Makes count tokens with consecutive ids, returning the first
+		inline Token make_tokens(size_t count) { return create_entities(count); }
+		inline void reserve_tokens(size_t count) { reserve_entities(count); }
+
+		template<typename Tattr, size_t Unique = 0>
+		inline void reserve_attribute(size_t count) { reserve_components<Tattr, Unique>(count); }
+
+		template<size_t Unique, typename... Tattrs, std::ranges::input_range Range, typename F = decltype([](Token, Tattrs&...) {})>
+		inline size_t add_attributes_bulk(Range&& tokens, const F& init = {}) { return add_components_bulk<Unique, Tattrs...>(std::forward<Range>(tokens), init); }
+		template<typename... Tattrs, std::ranges::input_range Range, typename F = decltype([](Token, Tattrs&...) {})>
+		inline size_t add_attributes_bulk(Range&& tokens, const F& init = {}) { return add_components_bulk<0, Tattrs...>(std::forward<Range>(tokens), init); }
 
 		template<typename Tattr, size_t Unique = 0>
 		inline Tattr& add_attribute(Token t) { return *add_component<Tattr, Unique>(t); }
@@ -55,10 +272,24 @@ namespace doir {
 			);
 		}
 
+		// Places the key directly into the hashtable (unlike add_hashtable_attribute which leaves it for the next rehash), returns false if the key is already present
+		// NOTE: Meant for incremental edits (eg. adding a declaration during an optimization pass), bulk additions are faster with add_hashtable_attribute
+		template<typename Tattr, size_t Unique = 0>
+		bool insert_hashtable_attribute(Token t, const Tattr& key) {
+			auto hashtable = get_hashtable<Tattr, Unique>(true);
+			if(!hashtable) return false;
+			return hashtable->insert(*this, t, key, static_cast<const Module&>(*this)).has_value();
+		}
+
 		template<typename Tattr, size_t Unique = 0>
 		bool remove_attribute(Token t) { return remove_component<Tattr, Unique>(t); }
+		// Removes the key from the hashtable in place, so the table doesn't need to be rebuilt
 		template<typename Tattr, size_t Unique = 0>
-		bool remove_hashtable_attribute(Token t) { return remove_component<hashtable_t<Tattr>, Unique>(t); }
+		bool remove_hashtable_attribute(Token t) {
+			auto hashtable = get_hashtable<Tattr, Unique>(true);
+			if(!hashtable) return false;
+			return hashtable->erase(*this, t, static_cast<const Module&>(*this));
+		}
 
 		template<typename Tattr, size_t Unique = 0>
 		inline ecs::optional_reference<Tattr> get_attribute(Token t) { return get_component<Tattr, Unique>(t); }
@@ -70,21 +301,52 @@ namespace doir {
 		template<typename Tattr, size_t Unique = 0>
 		inline auto get_hashtable_attribute(Token t) const { return get_component<hashtable_t<Tattr>, Unique>(t); }
 
+		// NOTE: Hashers and keys which need to look at the module (eg. to compare lexemes) are given it explicitly,
+		//	so lookups into the returned table should pass the module as well: `hashtable.find(key, module)`
+		// NOTE: Keys are hashed with wyhash::wyhash_64, key types with padding or which reference the module should specialize it
+		template<typename Tattr, size_t Unique = 0>
+		optional_reference<ecs::hashtable::component_storage<Tattr, void, wyhash::wyhash_64<Tattr>, Unique>> get_hashtable(bool skip_rehash = false) {
+			auto hashtable = ecs::get_adapted_component_storage<ecs::hashtable::component_storage<Tattr, void, wyhash::wyhash_64<Tattr>, Unique>>(*this);
+			if(!hashtable) return {};
+			if(!skip_rehash) if(!hashtable->rehash(*this, static_cast<const Module&>(*this))) return {};
+			return hashtable;
+		}
+
+		// Views the same attribute storage as a swiss table instead (see ecs::hashtable::swiss), a storage should only be viewed through one kind of hashtable
 		template<typename Tattr, size_t Unique = 0>
-		optional_reference<ecs::hashtable::component_storage<Tattr, void, fnv::fnv1a_64<Tattr>, Unique>> get_hashtable(bool skip_rehash = false) {
-			auto hashtable = ecs::get_adapted_component_storage<ecs::hashtable::component_storage<Tattr, void, fnv::fnv1a_64<Tattr>, Unique>>(*this);
+		optional_reference<ecs::hashtable::swiss::component_storage<Tattr, void, wyhash::wyhash_64<Tattr>, Unique>> get_swiss_hashtable(bool skip_rehash = false) {
+			auto hashtable = ecs::get_adapted_component_storage<ecs::hashtable::swiss::component_storage<Tattr, void, wyhash::wyhash_64<Tattr>, Unique>>(*this);
 			if(!hashtable) return {};
-			doir::hash_lookup_module = this;
-			if(!skip_rehash) if(!hashtable->rehash(*this)) return {};
+			if(!skip_rehash) if(!hashtable->rehash(*this, static_cast<const Module&>(*this))) return {};
 			return hashtable;
 		}
 
+		/**
+		* @brief Gets a secondary index (see doir::Index) over the module's attributes, creating it the first time it is requested
+		*
+		* @tparam Tindex The index, eg. `doir::Index<Declaration, decltype([](const Declaration& d) { return std::pair{d.parent, d.symbol}; })>`
+		* @return The index, brought up to date with any attributes added, removed, or reordered since it was last requested
+		* @note The reference stays valid for the life of the module, but is only up to date until attributes are next modified
+		*/
+		template<typename Tindex>
+		Tindex& get_index() {
+			size_t id = detail::index_id<Tindex>();
+			if(indices.size() <= id) indices.resize(id + 1);
+			if(!indices[id]) indices[id] = std::make_unique<Tindex>(memory);
+			auto& index = static_cast<Tindex&>(*indices[id]);
+			index.update(static_cast<const ecs::scene&>(*this));
+			return index;
+		}
+
 		template<typename Tattr, size_t Unique = 0>
 		inline bool has_attribute(Token t) const { return has_component<Tattr, Unique>(t); }
 
 		template<typename Tattr, size_t Unique = 0>
 		inline bool has_hashtable_attribute(Token t) const { return has_component<hashtable_t<Tattr>, Unique>(t); }
 
+		template<typename... Tattrs>
+		inline size_t first_attribute_of(Token t) const { return first_component_of<Tattrs...>(t); }
+
 		template<typename Tattr, size_t Unique = 0>
 		auto get_attribute_as_span() {
 			auto storage = ecs::get_adapted_component_storage<ecs::typed::component_storage<Tattr, Unique>>(*this);
@@ -104,8 +366,47 @@ namespace doir {
 		template<typename Tattr, size_t Unique = 0>
 		void make_monotonic() { ecs::scene::make_monotonic<Tattr, Unique>(); }
 
+		// Removes unowned attributes and sorts every (non hashtable) attribute storage by token, so traversals in token order walk memory linearly
+		void compact() { ecs::scene::compact(); }
+
+		// Reports how much memory each attribute (and the module's token book keeping) is using
+		inline memory_statistics statistics() const { return ecs::scene::statistics(); }
+
+		// Plots the module's memory usage in the profiler (a no-op unless DOIR_ENABLE_PROFILING is on)
+		// NOTE: Plots are identified by name, so every module shares the same plots
+		void plot_statistics() const {
+			auto stats = statistics();
+			auto plot = []([[maybe_unused]] const char* name, [[maybe_unused]] size_t bytes) { // Unused when profiling is disabled
+				TracyPlotConfig(name, tracy::PlotFormatType::Memory, true, true, 0);
+				TracyPlot(name, int64_t(bytes));
+			};
+			plot("doir::Module::total", stats.total_bytes());
+			plot("doir::Module::attributes", stats.component_bytes);
+			plot("doir::Module::entity_component_indices", stats.entity_component_indices_bytes);
+			plot("doir::Module::tokens", stats.entity_bytes);
+			for(auto& storage: stats.storages)
+				if(!storage.name.empty()) // Names are views of strings in the global component registry, so are null terminated and live forever
+					plot(storage.name.data(), storage.capacity_bytes + storage.index_bytes);
+		}
+
+		// A saved copy of the module which speculative passes can roll back to, attribute pages are only copied once they are modified
+		// NOTE: Only one snapshot may be taken of a module at a time, and the module must not move while it is alive
+		struct Snapshot {
+			ecs::scene::snapshot tokens;
+			std::pmr::string buffer;
+		};
+		inline Snapshot take_snapshot() { return {ecs::scene::take_snapshot(), {buffer, memory}}; }
+		// Rolls the module back to the state it was in when the snapshot was taken (the snapshot can be restored again afterwards)
+		void restore(Snapshot& snapshot) {
+			ecs::scene::restore(snapshot.tokens);
+			buffer = snapshot.buffer;
+		}
+
 		template<typename... Tattrs>
 		inline ecs::scene_view<Tattrs...> view() { return {*this}; }
+
+	protected:
+		std::pmr::vector<std::unique_ptr<detail::IndexBase>> indices; // Indexed by detail::index_id
 	};
 
 	// A module wrapped value assumes that the associated module won't move!
@@ -214,6 +515,11 @@ namespace doir {
 		using View = decltype(v);
 		return std::ranges::subrange<typename View::Iterator, typename View::Sentinel, std::ranges::subrange_kind::unsized>(v.begin(), v.end());
 	}
+
+	template<typename... Tattrs, typename F>
+	void par_for_each(Module& module, const F& f, size_t chunk_size = ECS_PARALLEL_CHUNK_SIZE, size_t thread_count = std::thread::hardware_concurrency()) {
+		module.view<Tattrs...>().par_for_each(f, chunk_size, thread_count);
+	}
 }
 
 namespace ecs::hashtable {
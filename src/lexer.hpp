@@ -196,7 +196,7 @@ namespace doir { inline namespace lex {
 		struct basic_single_line_comment {
 			static constexpr bool skip_if_invalid = true;
 			DOIR_INLINE static bool next_valid(size_t index, CharT next) noexcept {
-				static CharT last;
+				thread_local CharT last;
 				if(index == 0) last = 0;
 				if(last == '\n') return false;
 				last = next;
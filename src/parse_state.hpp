@@ -61,13 +61,20 @@ namespace doir {
 		}
 		inline ParseState& lex(/*doir::lex::detail::instantiation_of_lexer<doir::lex::basic_lexer>*/ auto& lexer) { return lex(lexer, *this); }
 
-		static Token make_token(const ParseState& state, Module& module, bool ignore_invalid = false) {
+		// Makes count tokens (with consecutive ids) which all share the current lexeme and location, returning the first
+		static Token make_tokens(const ParseState& state, Module& module, size_t count, bool ignore_invalid = false) {
 			if(!state.lexer_state.valid() && !ignore_invalid) return 0;
-			auto t = module.make_token();
-			module.add_attribute<Lexeme>(t) = *Lexeme::from_view(module.buffer, state.lexer_state.lexeme);
-			module.add_attribute<NamedSourceLocation>(t) = state.source_location;
-			return t;
+			auto first = module.make_tokens(count);
+			auto lexeme = *Lexeme::from_view(module.buffer, state.lexer_state.lexeme);
+			module.add_attributes_bulk<Lexeme, NamedSourceLocation>(std::views::iota(first, Token(first + count)), [&](Token, Lexeme& l, NamedSourceLocation& location) {
+				l = lexeme;
+				location = state.source_location;
+			});
+			return first;
 		}
+		inline Token make_tokens(Module& module, size_t count, bool ignore_invalid = false) const { return make_tokens(*this, module, count, ignore_invalid); }
+
+		static Token make_token(const ParseState& state, Module& module, bool ignore_invalid = false) { return make_tokens(state, module, 1, ignore_invalid); }
 		inline Token make_token(Module& module, bool ignore_invalid = false) const { return make_token(*this, module, ignore_invalid); }
 
 		template<typename... Tattrs>
@@ -113,10 +120,23 @@ namespace doir {
 	};
 
 	struct ParseModule: public Module, public ParseState {
-		ParseModule(const std::string& buffer = "", NamedSourceLocation location = {}) : Module(buffer), ParseState(this->buffer, location) {}
+		ParseModule(const std::string& buffer = "", NamedSourceLocation location = {}, ecs::storage_mode mode = default_storage_mode, std::pmr::memory_resource* resource = nullptr)
+			: Module(buffer, mode, resource), ParseState(this->buffer, location) {}
+
+		// Rough guess of how many tokens parsing the buffer will produce (assumes an average of 4 characters per token, including whitespace)
+		inline size_t estimated_token_count() const { return buffer.size() / 4 + 1; }
+
+		// Presizes the token book keeping and the attributes every token receives, so that they don't need to regrow while parsing
+		inline void reserve_for_tokens(size_t count) {
+			reserve_tokens(count);
+			reserve_attribute<Lexeme>(count);
+			reserve_attribute<NamedSourceLocation>(count);
+		}
+		inline void reserve_for_tokens() { reserve_for_tokens(estimated_token_count()); }
 
 		inline Token make_token(const ParseState& state, bool ignore_invalid = false) { return ParseState::make_token(state, *this, ignore_invalid); }
 		inline Token make_token(bool ignore_invalid = false) { return ParseState::make_token(*this, ignore_invalid); }
+		inline Token make_tokens(size_t count, bool ignore_invalid = false) { return ParseState::make_tokens(*this, count, ignore_invalid); }
 
 		template<typename... Tattrs>
 		inline Token make_token_with(const ParseState& state, Tattrs... attributes) {
@@ -1,6 +1,8 @@
 #include "../ECS/ecs.hpp"
 #include "../ECS/query.hpp"
 #include "../ECS/adapter.hpp"
+#include <set>
+#include <thread>
 
 #include "tests.utils.hpp"
 
@@ -60,6 +62,397 @@ TEST_SUITE("ECS") {
 		CHECK(*scene.get_component<float>(e3) == 3);
 	}
 
+	TEST_CASE("ECS::Generations") {
+		ZoneScoped;
+		ecs::scene scene;
+		auto a = scene.create_entity_handle();
+		auto b = scene.create_entity_handle();
+		auto c = scene.create_entity_handle();
+		*scene.add_component<float>(a.index) = 1;
+		*scene.add_component<float>(c.index) = 3;
+		*scene.add_component<int>(c.index) = 3;
+		CHECK(scene.is_valid(a));
+
+		// Releasing only removes the entity's own components and invalidates its handles
+		CHECK(scene.release_entity(c));
+		CHECK(!scene.is_valid(c));
+		CHECK(!scene.release_entity(c));
+		CHECK(!scene.release_entity(c.index)); // Double releasing would put the entity on the free list twice
+		CHECK(scene.get_storage<int>()->empty());
+		CHECK(*scene.get_component<float>(a.index) == 1);
+		CHECK(scene.release_entity(a.index));
+		CHECK(scene.size() == 1);
+
+		// Entities are recycled in the order they were released, and recycled ids don't revive stale handles
+		auto d = scene.create_entity_handle();
+		auto e = scene.create_entity_handle();
+		CHECK(d.index == c.index);
+		CHECK(e.index == a.index);
+		CHECK(d != c);
+		CHECK(!scene.is_valid(c));
+		CHECK(scene.is_valid(d));
+		CHECK(scene.is_valid(b));
+		CHECK(!scene.has_component<float>(d.index));
+		CHECK(scene.create_entity() == 3);
+
+		// Swapping moves an entity's data (and whether it is alive) to the other id, so handles to either id are invalidated
+		auto f = scene.create_entity_handle();
+		CHECK(scene.release_entity(f));
+		scene.swap_entities(b.index, f.index);
+		CHECK(!scene.is_valid(b));
+		CHECK(!scene.is_alive(b.index));
+		CHECK(scene.is_alive(f.index));
+		CHECK(scene.create_entity() == b.index); // The free list follows the released entity
+
+		// As does reordering, for every entity which moves
+		std::vector<ecs::entity_handle> handles;
+		for(ecs::entity id = 0; id < scene.size(); ++id)
+			handles.push_back(scene.handle(id));
+		std::vector<size_t> order(scene.size());
+		std::iota(order.rbegin(), order.rend(), 0);
+		scene.reorder_entities(order);
+		for(ecs::entity id = 0; id < handles.size(); ++id)
+			CHECK(scene.is_valid(handles[id]) == (id == handles.size() / 2));
+		CHECK(scene.size() == handles.size());
+	}
+
+	TEST_CASE("ECS::BulkAdd") {
+		ZoneScoped;
+		for(auto mode: {ecs::storage_mode::sparse_set, ecs::storage_mode::archetype}) {
+			ecs::scene scene;
+			scene.mode = mode;
+			constexpr size_t count = 1000;
+			scene.reserve_entities(count);
+			auto first = scene.create_entities(count);
+			CHECK(scene.size() == count);
+			CHECK(scene.create_entity() == first + count);
+
+			size_t added = scene.add_components_bulk<float, ecs::with_entity<int>>(std::views::iota(first, first + count), [](ecs::entity e, float& f, ecs::with_entity<int>& i) {
+				f = e;
+				i.value = -int(e);
+			});
+			CHECK(added == count);
+			auto& storage = *scene.get_storage<ecs::with_entity<int>>();
+			CHECK(storage.size() == count);
+			CHECK(storage.pages.size() == (count + storage.elements_per_page - 1) / storage.elements_per_page); // Grown once up front
+			for(ecs::entity e = first; e < first + count; ++e) {
+				CHECK(*scene.get_component<float>(e) == e);
+				CHECK(scene.get_component<ecs::with_entity<int>>(e)->value == -int(e));
+				CHECK(scene.get_component<ecs::with_entity<int>>(e)->entity == e);
+			}
+
+			// Without an initializer the components are default constructed
+			CHECK(scene.add_components_bulk<double>(std::vector<ecs::entity>{first, first + 1}) == 2);
+			CHECK(*scene.get_component<double>(first + 1) == 0);
+
+			// Unique storages are kept apart from the untagged ones
+			CHECK(scene.add_components_bulk<1, double>(std::vector<ecs::entity>{first + 2}, [](ecs::entity, double& d) { d = 5; }) == 1);
+			CHECK(*scene.get_component<double, 1>(first + 2) == 5);
+			CHECK(!scene.has_component<double>(first + 2));
+			CHECK(!scene.has_component<double, 1>(first + 1));
+		}
+	}
+
+	TEST_CASE("ECS::SparseIndex") {
+		ZoneScoped;
+		ecs::scene scene;
+		constexpr size_t count = ecs::scene::component_storage::page_size * 3;
+		for(size_t i = 0; i < count; ++i)
+			scene.create_entity();
+
+		// Only touch entities spread across the first and last pages
+		*scene.add_component<float>(1) = 1;
+		*scene.add_component<float>(count - 1) = 2;
+		auto& storage = *scene.get_storage<float>();
+		CHECK(storage.size() == 2);
+		CHECK(storage.sparse.size() == 3);
+		CHECK(storage.sparse[1].empty());
+		CHECK(storage.entity_of(0) == 1);
+		CHECK(storage.entity_of(1) == count - 1);
+
+		CHECK(scene.has_component<float>(1));
+		CHECK(!scene.has_component<float>(2));
+		CHECK(!scene.has_component<float>(count + 100));
+		CHECK(*scene.get_component<float>(count - 1) == 2);
+
+		// Adding a component twice reuses the existing element
+		*scene.add_component<float>(1) = 3;
+		CHECK(storage.size() == 2);
+		CHECK(*scene.get_component<float>(1) == 3);
+
+		CHECK(scene.release_entity(1));
+		CHECK(!scene.has_component<float>(1));
+		CHECK(storage.size() == 1);
+		CHECK(storage.entity_of(0) == count - 1);
+		CHECK(*scene.get_component<float>(count - 1) == 2);
+	}
+
+	TEST_CASE("ECS::PagedStorage") {
+		ZoneScoped;
+		ecs::scene scene;
+		constexpr size_t count = ecs::scene::component_storage::elements_per_page * 4 + 3;
+		auto first = scene.create_entity();
+		auto& reference = *scene.add_component<float>(first);
+		reference = -1;
+		for(size_t i = 1; i < count; ++i)
+			*scene.add_component<float>(scene.create_entity()) = i;
+
+		// Adding components to a paged storage never moves the existing ones
+		auto& storage = *scene.get_storage<float>();
+		CHECK(!storage.is_contiguous());
+		CHECK(storage.pages.size() == 5);
+		CHECK(&reference == &*scene.get_component<float>(first));
+		CHECK(reference == -1);
+
+		// Removing the first element moves the last one into its slot
+		CHECK(scene.remove_component<float>(first));
+		CHECK(*(float*)storage.element(0) == count - 1);
+		CHECK(*scene.get_component<float>(count - 1) == count - 1);
+
+		// Opting into the contiguous layout keeps every value and allows viewing the storage as a span
+		storage.set_layout(ecs::scene::component_storage::layout::contiguous);
+		CHECK(storage.is_contiguous());
+		CHECK(storage.pages.empty());
+		CHECK(storage.size() == count - 1);
+		auto span = ecs::get_adapted_component_storage<ecs::typed::component_storage<float>>(scene)->span();
+		CHECK(span.size() == count - 1);
+		for(ecs::entity e = 1; e < count; ++e)
+			CHECK(*scene.get_component<float>(e) == e);
+
+		storage.set_layout(ecs::scene::component_storage::layout::paged);
+		CHECK(storage.data.empty());
+		for(ecs::entity e = 1; e < count; ++e)
+			CHECK(*scene.get_component<float>(e) == e);
+	}
+
+	struct counted {
+		static inline int64_t live = 0;
+		std::string value = "a string long enough to not fit in the small string buffer";
+		counted() { ++live; }
+		counted(const counted& o) : value(o.value) { ++live; }
+		counted(counted&& o) : value(std::move(o.value)) { ++live; }
+		counted& operator=(const counted&) = default;
+		counted& operator=(counted&&) = default;
+		~counted() { --live; }
+	};
+
+	TEST_CASE("ECS::Lifetime") {
+		ZoneScoped;
+		static_assert(!ecs::is_trivially_relocatable_v<counted>);
+		static_assert(ecs::is_trivially_relocatable_v<float>);
+
+		{
+			ecs::scene scene;
+			constexpr size_t count = ecs::scene::component_storage::elements_per_page * 2;
+			for(size_t i = 0; i < count; ++i)
+				scene.add_component<counted>(scene.create_entity())->value += std::to_string(i);
+			CHECK(counted::live == count);
+
+			// Removing (and releasing) destroys the element and moves the last one into its place
+			CHECK(scene.remove_component<counted>(0));
+			CHECK(scene.release_entity(1));
+			CHECK(counted::live == count - 2);
+			CHECK(scene.get_component<counted>(count - 1)->value.ends_with(std::to_string(count - 1)));
+
+			// Switching layouts, sorting (with and without types), and copying keep every element alive exactly once
+			auto& storage = *scene.get_storage<counted>();
+			storage.set_layout(ecs::scene::component_storage::layout::contiguous);
+			storage.sort_monotonic<counted>(scene);
+			storage.sort(scene, ecs::get_global_component_id<counted>(), [](void* a, void* b) {
+				return ((counted*)a)->value > ((counted*)b)->value;
+			});
+			CHECK(counted::live == count - 2);
+			for(ecs::entity e = 2; e < count; ++e)
+				CHECK(scene.get_component<counted>(e)->value.ends_with(std::to_string(e)));
+			{
+				auto copy = storage;
+				CHECK(counted::live == 2 * (count - 2));
+			}
+			CHECK(counted::live == count - 2);
+
+			// Growing the contiguous storage relocates the existing elements
+			for(size_t i = 0; i < count; ++i)
+				scene.add_component<counted>(scene.create_entity());
+			CHECK(counted::live == 2 * count - 2);
+			CHECK(scene.get_component<counted>(2)->value.ends_with("2"));
+		}
+		CHECK(counted::live == 0);
+	}
+
+	TEST_CASE("ECS::Statistics") {
+		ZoneScoped;
+		for(auto mode: {ecs::storage_mode::sparse_set, ecs::storage_mode::archetype}) {
+			ecs::scene scene;
+			scene.mode = mode;
+			scene.create_entities(1000);
+			for(ecs::entity e = 0; e < 1000; ++e) {
+				*scene.add_component<float>(e) = e;
+				if(e % 10 == 0) *scene.add_component<std::string>(e) = "value";
+			}
+			for(ecs::entity e = 0; e < 1000; e += 2)
+				scene.remove_component<float>(e);
+
+			auto stats = scene.statistics();
+			auto find = [&](size_t id) { return *std::ranges::find(stats.storages, id, &ecs::scene::storage_statistics::component_id); };
+			auto floats = find(ecs::get_global_component_id<float>());
+			CHECK(floats.name == ecs::get_global_component_name(floats.component_id));
+			CHECK(floats.element_count == 500);
+			CHECK(floats.element_size == sizeof(float));
+			CHECK(floats.capacity_bytes >= 500 * sizeof(float));
+			CHECK(floats.fragmentation() > 0);
+			auto strings = find(ecs::get_global_component_id<std::string>());
+			CHECK(strings.element_count == 100);
+			CHECK(strings.index_bytes > 0); // Never stored in archetypes, so always indexed by its storage
+
+			size_t component_bytes = 0;
+			for(auto& storage: stats.storages) component_bytes += storage.capacity_bytes;
+			CHECK(stats.component_bytes == component_bytes);
+			CHECK(stats.entity_bytes >= 1000 * sizeof(uint32_t));
+			CHECK(stats.total_bytes() == stats.component_bytes + stats.entity_component_indices_bytes + stats.entity_bytes);
+
+			scene.compact();
+			CHECK(scene.statistics().storages.size() == stats.storages.size());
+		}
+	}
+
+	// Counts the bytes currently allocated from it (forwarding to the default resource)
+	struct counting_resource : public std::pmr::memory_resource {
+		size_t allocated = 0;
+		void* do_allocate(size_t bytes, size_t alignment) override { allocated += bytes; return std::pmr::get_default_resource()->allocate(bytes, alignment); }
+		void do_deallocate(void* p, size_t bytes, size_t alignment) override { allocated -= bytes; std::pmr::get_default_resource()->deallocate(p, bytes, alignment); }
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+	};
+
+	TEST_CASE("ECS::MemoryResource") {
+		ZoneScoped;
+		static_assert(ecs::detail::uses_memory_resource<std::pmr::string> && !ecs::detail::uses_memory_resource<std::string>);
+		counting_resource counter;
+		{
+			ecs::scene scene(&counter);
+			scene.create_entities(1000);
+			for(ecs::entity e = 0; e < 1000; ++e) {
+				*scene.add_component<float>(e) = e;
+				*scene.add_component<std::pmr::string>(e) = "a string long enough to not fit in the small string buffer " + std::to_string(e);
+			}
+			CHECK(counter.allocated > 1000 * 60);
+			CHECK(scene.get_component<std::pmr::string>(10)->get_allocator().resource() == &counter);
+
+			// Elements keep allocating from the scene's resource as they are moved around...
+			for(ecs::entity e = 0; e < 1000; e += 3)
+				scene.remove_component<std::pmr::string>(e);
+			scene.compact();
+			CHECK(scene.get_component<std::pmr::string>(10)->get_allocator().resource() == &counter);
+			CHECK(*scene.get_component<std::pmr::string>(10) == "a string long enough to not fit in the small string buffer 10");
+
+			// ... and copies of a storage allocate from the resource they are given
+			auto& storage = *scene.get_storage<std::pmr::string>();
+			ecs::scene::component_storage copy(storage, std::pmr::get_default_resource());
+			CHECK(((std::pmr::string*)copy.element(0))->get_allocator().resource() == std::pmr::get_default_resource());
+			CHECK(*(std::pmr::string*)copy.element(0) == *(std::pmr::string*)storage.element(0));
+
+			// Moving between resources moves the elements rather than their memory
+			ecs::scene::component_storage moved(ecs::scene::component_storage::allocator_type{&counter});
+			moved = std::move(copy);
+			CHECK(moved.resource() == &counter);
+			CHECK(*(std::pmr::string*)moved.element(0) == *(std::pmr::string*)storage.element(0));
+		}
+		{
+			// Archetype tables allocate from the scene's resource, even once they have been sorted
+			ecs::scene scene(&counter);
+			scene.mode = ecs::storage_mode::archetype;
+			scene.create_entities(100);
+			for(ecs::entity e = 100; e--; )
+				*scene.add_component<float>(e) = e;
+			scene.compact();
+			CHECK(*scene.get_component<float>(10) == 10);
+			for(auto& table: scene.archetypes)
+				CHECK(table.chunks.get_allocator().resource() == &counter);
+		}
+		CHECK(counter.allocated == 0);
+
+		// A monotonic arena frees everything at once
+		std::pmr::monotonic_buffer_resource arena;
+		ecs::scene scene(&arena);
+		for(size_t i = 0; i < 100; ++i)
+			scene.add_component<std::pmr::vector<ecs::entity>>(scene.create_entity())->push_back(i);
+		CHECK(scene.resource() == &arena);
+		CHECK(scene.get_component<std::pmr::vector<ecs::entity>>(50)->front() == 50);
+	}
+
+	TEST_CASE("ECS::Snapshot") {
+		ZoneScoped;
+		for(auto mode: {ecs::storage_mode::sparse_set, ecs::storage_mode::archetype}) {
+			constexpr size_t count = 4 * ecs::scene::component_storage::elements_per_page;
+			ecs::scene scene;
+			scene.mode = mode;
+			scene.create_entities(count);
+			for(ecs::entity e = 0; e < count; ++e) {
+				*scene.add_component<float>(e) = e;
+				*scene.add_component<std::string>(e) = "a string long enough to not fit in the small string buffer " + std::to_string(e);
+			}
+			auto check = [&] {
+				CHECK(scene.size() == count);
+				for(ecs::entity e = 0; e < count; ++e) {
+					CHECK(*scene.get_component<float>(e) == e);
+					CHECK(*scene.get_component<std::string>(e) == "a string long enough to not fit in the small string buffer " + std::to_string(e));
+					CHECK(!scene.has_component<int>(e));
+				}
+			};
+
+			auto snapshot = scene.take_snapshot();
+			{
+				// Reading (and writing to a single page) only copies the page which was written to
+				const auto& constant = scene;
+				CHECK(*constant.get_component<std::string>(count - 1) == "a string long enough to not fit in the small string buffer " + std::to_string(count - 1));
+				*scene.get_component<std::string>(0) = "modified";
+				auto& journal = *snapshot.journals[ecs::get_global_component_id<std::string>()];
+				CHECK(std::ranges::count_if(journal.saved, [](auto& page) { return !page.empty(); }) == 1);
+			}
+			{
+				// Pages can be preserved from several threads at once
+				ecs::par_for_each<float>(scene, [](auto tuple) { std::get<0>(tuple) += 0.5f; }, 16, 4);
+				scene.restore(snapshot);
+				check();
+			}
+			for(size_t round = 0; round < 2; ++round) {
+				// Modify, remove, add, and reorder components (and entities)...
+				for(ecs::entity e = 0; e < count; e += 7)
+					*scene.get_component<float>(e) = -1;
+				for(ecs::entity e = 1; e < count; e += 3)
+					scene.remove_component<std::string>(e);
+				*scene.add_component<int>(5) = 5;
+				scene.release_entity(10);
+				scene.create_entity();
+				scene.compact();
+
+				// ... and restoring undoes all of it
+				scene.restore(snapshot);
+				check();
+			}
+		}
+	}
+
+	TEST_CASE("ECS::Benchmark::Remove" * doctest::skip()) {
+		ZoneScopedN("ECS::Benchmark::Remove");
+		constexpr size_t count = 1'000'000;
+		ecs::scene scene;
+		{
+			ZoneScopedN("ECS::Benchmark::Remove::add");
+			for(size_t i = 0; i < count; ++i)
+				*scene.add_component<size_t>(scene.create_entity()) = i;
+		}
+		bool valid = true;
+		{
+			ZoneScopedN("ECS::Benchmark::Remove::remove");
+			// Remove from the front so every removal has to move the last element into the hole
+			for(ecs::entity e = 0; e < count; ++e)
+				valid &= scene.remove_component<size_t>(e);
+		}
+		CHECK(valid);
+		CHECK(scene.get_storage<size_t>()->empty());
+		FrameMark;
+	}
+
 	TEST_CASE("ECS::Query") {
 		ZoneScoped;
 		ecs::scene scene;
@@ -79,6 +472,285 @@ TEST_SUITE("ECS") {
 		}
 	}
 
+	TEST_CASE("ECS::QuerySmallestStorage") {
+		ZoneScoped;
+		ecs::scene scene;
+		for(size_t i = 0; i < 100; ++i)
+			*scene.add_component<float>(scene.create_entity()) = i;
+		*scene.add_component<double>(90) = 90;
+		*scene.add_component<double>(10) = 10;
+		*scene.add_component<double>(50) = 50;
+
+		// Driven by the double storage (which is smaller) but still requires the float
+		size_t count = 0;
+		for(auto [e, f, d]: ecs::query<ecs::include_entity, float, double>(scene)) {
+			CHECK(f == d);
+			CHECK(e == f);
+			++count;
+		}
+		CHECK(count == 3);
+
+		// Optionals never drive iteration
+		count = 0;
+		for(auto [e, d, f]: ecs::query<ecs::include_entity, double, std::optional<float>>(scene)) {
+			CHECK(f);
+			CHECK(*f == d);
+			++count;
+		}
+		CHECK(count == 3);
+
+		// Neither do ors
+		count = 0;
+		for(auto [e, value]: ecs::query<ecs::include_entity, ecs::or_<double, float>>(scene)) {
+			CHECK(value.index() != 0);
+			++count;
+		}
+		CHECK(count == 100);
+
+		// Components which have never been added match nothing
+		count = 0;
+		for([[maybe_unused]] auto [e, f, b]: ecs::query<ecs::include_entity, float, bool>(scene))
+			++count;
+		CHECK(count == 0);
+	}
+
+	TEST_CASE("ECS::QueryRecycledEntity") {
+		ZoneScoped;
+		ecs::scene scene;
+		auto a = scene.create_entity(), b = scene.create_entity();
+		*scene.add_component<float>(a) = 1;
+		*scene.add_component<float>(b) = 2;
+		CHECK(scene.release_entity(a, false)); // Leaves a's float behind without an owner
+		auto c = scene.create_entity();
+		CHECK(c == a);
+		*scene.add_component<float>(c) = 3;
+
+		// The element a left behind must not be visited as c's
+		size_t count = 0;
+		float sum = 0;
+		for(auto [e, f]: ecs::query<ecs::include_entity, float>(scene)) {
+			CHECK(f == (e == c ? 3 : 2));
+			sum += f;
+			++count;
+		}
+		CHECK(count == 2);
+		CHECK(sum == 5);
+
+		std::atomic<size_t> visits = 0;
+		ecs::par_for_each<float>(scene, [&visits](auto) { ++visits; }, 1, 4);
+		CHECK(visits == 2);
+	}
+
+	TEST_CASE("ECS::QueryRemoveCurrent") {
+		ZoneScoped;
+		ecs::scene scene;
+		for(size_t i = 0; i < 10; ++i)
+			*scene.add_component<size_t>(scene.create_entity()) = i;
+
+		// Removing the current entity's element moves the last element into its slot, which must still be visited
+		size_t count = 0, sum = 0;
+		for(auto [e, value]: ecs::query<ecs::include_entity, size_t>(scene)) {
+			sum += value;
+			++count;
+			CHECK(scene.remove_component<size_t>(e));
+		}
+		CHECK(count == 10);
+		CHECK(sum == 45);
+		CHECK(scene.get_storage<size_t>()->size() == 0);
+	}
+
+	TEST_CASE("ECS::Benchmark::RareQuery" * doctest::skip()) {
+		ZoneScopedN("ECS::Benchmark::RareQuery");
+		constexpr size_t count = 1'000'000;
+		ecs::scene scene;
+		for(size_t i = 0; i < count; ++i) {
+			auto e = scene.create_entity();
+			*scene.add_component<size_t>(e) = i;
+			if(i % 1000 == 0) scene.add_component<bool>(e);
+		}
+
+		size_t matches = 0;
+		{
+			ZoneScopedN("ECS::Benchmark::RareQuery::query");
+			for(auto [value, tag]: ecs::query<size_t, bool>(scene))
+				matches += value % 1000 == 0;
+		}
+		CHECK(matches == count / 1000);
+		FrameMark;
+	}
+
+	TEST_CASE("ECS::ParallelQuery") {
+		ZoneScoped;
+		constexpr size_t count = 10'000;
+		for(auto mode: {ecs::storage_mode::sparse_set, ecs::storage_mode::archetype}) {
+			ecs::scene scene;
+			scene.mode = mode;
+			for(size_t i = 0; i < count; ++i) {
+				auto e = scene.create_entity();
+				*scene.add_component<float>(e) = i;
+				if(i % 3 == 0) *scene.add_component<double>(e) = i;
+			}
+
+			// Per entity writes
+			std::atomic<size_t> mismatches = 0;
+			ecs::scene_view<ecs::include_entity, float>{scene}.par_for_each([&mismatches](auto tuple) {
+				auto [e, value] = tuple;
+				if(e != value) ++mismatches;
+				value *= 2;
+			}, 64, 4);
+			CHECK(mismatches == 0);
+			for(ecs::entity e = 0; e < count; ++e)
+				CHECK(*scene.get_component<float>(e) == e * 2);
+
+			std::atomic<size_t> matches = 0;
+			ecs::par_for_each<float, double>(scene, [&matches](auto tuple) {
+				auto [f, d] = tuple;
+				if(f == d * 2) ++matches;
+			}, 64, 4);
+			CHECK(matches == (count + 2) / 3);
+
+			matches = 0;
+			ecs::par_for_each<std::optional<double>>(scene, [&matches](auto tuple) {
+				auto [d] = tuple;
+				if(d) ++matches;
+			}, 64, 4);
+			CHECK(matches == (count + 2) / 3);
+
+			// Exceptions thrown by a worker are rethrown on the calling thread (and stop the remaining chunks from being handed out)
+			std::atomic<size_t> visits = 0;
+			CHECK_THROWS_AS(ecs::par_for_each<float>(scene, [&visits](auto tuple) {
+				++visits;
+				if(std::get<0>(tuple) == 100) throw std::runtime_error("stop");
+			}, 8, 4), std::runtime_error);
+			CHECK(visits < count);
+		}
+	}
+
+	TEST_CASE("ECS::Signature") {
+		ZoneScoped;
+		for(auto mode: {ecs::storage_mode::sparse_set, ecs::storage_mode::archetype}) {
+			ecs::scene scene;
+			scene.mode = mode;
+			auto e0 = scene.create_entity();
+			auto e1 = scene.create_entity();
+			scene.add_component<float>(e0);
+			scene.add_component<double>(e0);
+			scene.add_component<double>(e1);
+
+			CHECK(scene.signature(e0).test(ecs::get_global_component_id<float>()));
+			CHECK(scene.signature(e0).test(ecs::get_global_component_id<double>()));
+			CHECK(!scene.signature(e1).test(ecs::get_global_component_id<float>()));
+			CHECK(scene.first_component_of<float, double>(e0) == 0);
+			CHECK(scene.first_component_of<float, double>(e1) == 1);
+			CHECK(scene.first_component_of<bool, int>(e1) == 2);
+
+			CHECK(scene.remove_component<float>(e0));
+			CHECK(!scene.has_component<float>(e0));
+			CHECK(scene.first_component_of<float, double>(e0) == 1);
+
+			scene.swap_entities(e0, e1);
+			CHECK(scene.has_component<double>(e1));
+			CHECK(scene.first_component_of<float, double>(e0) == 1);
+
+			CHECK(scene.release_entity(e0));
+			CHECK(scene.signature(e0) == ecs::component_signature{});
+			CHECK(scene.first_component_of<float, double>(e0) == 2);
+		}
+	}
+
+	TEST_CASE("ECS::Archetype") {
+		ZoneScoped;
+		ecs::scene scene;
+		scene.mode = ecs::storage_mode::archetype;
+		auto e0 = scene.create_entity();
+		auto e1 = scene.create_entity();
+		auto e2 = scene.create_entity();
+		*scene.add_component<float>(e0) = 1;
+		*scene.add_component<float>(e1) = 2;
+		*scene.add_component<double>(e1) = 20;
+		*scene.add_component<float>(e2) = 3;
+		*scene.add_component<double>(e2) = 30;
+		scene.add_component<ecs::with_entity<int>>(e2)->value = 300;
+
+		CHECK(scene.archetypes.size() == 3); // {}, {float}, {float, double}
+		CHECK(scene.get_storage<float>()->empty()); // Stored in the archetype tables instead
+		CHECK(scene.get_storage<ecs::with_entity<int>>()->size() == 1);
+		CHECK(*scene.get_component<float>(e1) == 2);
+		CHECK(*scene.get_component<double>(e2) == 30);
+		CHECK(!scene.has_component<double>(e0));
+
+		size_t count = 0;
+		for(auto [e, f, d]: ecs::query<ecs::include_entity, float, double>(scene)) {
+			CHECK(f * 10 == d);
+			++count;
+		}
+		CHECK(count == 2);
+
+		count = 0;
+		for(auto [e, f, i]: ecs::query<ecs::include_entity, float, ecs::with_entity<int>>(scene)) {
+			CHECK(e == e2);
+			CHECK(i.value == 300);
+			++count;
+		}
+		CHECK(count == 1);
+
+		// Removing a component moves the entity (and everything it still has) to another table
+		CHECK(scene.remove_component<double>(e1));
+		CHECK(!scene.has_component<double>(e1));
+		CHECK(*scene.get_component<float>(e1) == 2);
+		CHECK(*scene.get_component<double>(e2) == 30);
+
+		CHECK(scene.release_entity(e0));
+		CHECK(!scene.has_component<float>(e0));
+		CHECK(*scene.get_component<float>(e1) == 2);
+		CHECK(*scene.get_component<float>(e2) == 3);
+	}
+
+	TEST_CASE("ECS::ComponentNames") {
+		ZoneScoped;
+		size_t id = ecs::get_global_component_id<float>();
+		CHECK(ecs::get_global_component_id<float>() == id);
+		CHECK(ecs::get_global_component_id<float, 1>() != id);
+		CHECK(ecs::get_global_component_name(id) == "float");
+		CHECK(ecs::get_global_component_id_by_name("float") == id);
+		CHECK(ecs::get_global_component_name(ecs::get_global_component_id<float, 1>()) == "float1");
+
+		// Names which don't belong to a type are assigned new ids
+		size_t runtime = ecs::get_global_component_id_by_name("ECS::ComponentNames::runtime");
+		CHECK(runtime != id);
+		CHECK(ecs::get_global_component_id_by_name("ECS::ComponentNames::runtime") == runtime);
+		CHECK(ecs::get_global_component_name(runtime) == "ECS::ComponentNames::runtime");
+	}
+
+	TEST_CASE("ECS::ConcurrentRegistry") {
+		ZoneScoped;
+		constexpr size_t thread_count = 8, name_count = 100;
+		std::vector<std::vector<size_t>> shared(thread_count), unique(thread_count), typed(thread_count);
+		std::vector<std::thread> threads;
+		for(size_t t = 0; t < thread_count; ++t)
+			threads.emplace_back([&, t] {
+				for(size_t i = 0; i < name_count; ++i) {
+					shared[t].push_back(ecs::get_global_component_id_by_name("ECS::ConcurrentRegistry::shared" + std::to_string(i)));
+					unique[t].push_back(ecs::get_global_component_id_by_name("ECS::ConcurrentRegistry::" + std::to_string(t) + "::" + std::to_string(i)));
+				}
+				[&]<size_t... I>(std::index_sequence<I...>) {
+					(typed[t].push_back(ecs::get_global_component_id<std::integral_constant<size_t, I>>()), ...);
+				}(std::make_index_sequence<32>{});
+			});
+		for(auto& thread: threads)
+			thread.join();
+
+		std::set<size_t> unique_ids;
+		for(size_t t = 0; t < thread_count; ++t) {
+			CHECK(shared[t] == shared[0]);
+			CHECK(typed[t] == typed[0]);
+			unique_ids.insert(unique[t].begin(), unique[t].end());
+		}
+		CHECK(unique_ids.size() == thread_count * name_count);
+		for(size_t i = 0; i < name_count; ++i)
+			CHECK(ecs::get_global_component_name(shared[0][i]) == "ECS::ConcurrentRegistry::shared" + std::to_string(i));
+	}
+
 	TEST_CASE("ECS::SortByValue") {
 		ZoneScoped;
 		ecs::scene scene;
@@ -93,7 +765,7 @@ TEST_SUITE("ECS") {
 
 		auto& storage = *scene.get_storage<float>();
 		storage.sort_by_value<float>(scene);
-		float* storage_as_float = (float*)storage.data.data();
+		float* storage_as_float = (float*)storage.element(0);
 		CHECK(storage_as_float[0] == 0);
 		CHECK(*scene.get_component<float>(e0) == 3);
 		CHECK(storage_as_float[1] == 3);
@@ -119,7 +791,7 @@ TEST_SUITE("ECS") {
 		auto& storage = *scene.get_storage<float>();
 		storage.sort_monotonic<float>(scene);
 		// scene.make_monotonic();
-		float* storage_as_float = (float*)storage.data.data();
+		float* storage_as_float = (float*)storage.element(0);
 		CHECK(storage_as_float[0] == 3);
 		CHECK(*scene.get_component<float>(e0) == 3);
 		CHECK(storage_as_float[1] == 27);
@@ -130,6 +802,267 @@ TEST_SUITE("ECS") {
 		CHECK(*scene.get_component<float>(e3) == 0);
 	}
 
+	TEST_CASE("ECS::SortByKey") {
+		ZoneScoped;
+		ecs::scene scene;
+		std::vector<int> ints = {5, -3, 1'000'000, -1'000'000, 0, 7, -3};
+		std::vector<double> doubles = {2.5, -0.5, -100, 1e10, 0, -1e-10, 3};
+		scene.create_entities(ints.size());
+		for(ecs::entity e = 0; e < ints.size(); ++e) {
+			*scene.add_component<int>(e) = ints[e];
+			*scene.add_component<double>(e) = doubles[e];
+		}
+
+		scene.get_storage<int>()->sort_by_value<int>(scene);
+		scene.get_storage<double>()->sort_by_value<double>(scene);
+		std::sort(ints.begin(), ints.end());
+		std::sort(doubles.begin(), doubles.end());
+		for(size_t i = 0; i < ints.size(); ++i) {
+			CHECK(*(int*)scene.get_storage<int>()->element(i) == ints[i]);
+			CHECK(*(double*)scene.get_storage<double>()->element(i) == doubles[i]);
+		}
+		for(ecs::entity e = 0; e < ints.size(); ++e)
+			CHECK(scene.get_component<double>(e).has_value());
+
+		// Non-radix keys big enough to be merged in parallel
+		constexpr size_t count = ECS_PARALLEL_SORT_THRESHOLD * 2 + 17;
+		scene.create_entities(count);
+		for(ecs::entity e = 0; e < count; ++e)
+			*scene.add_component<std::string>(e) = std::to_string((e * 7919) % count);
+		auto& strings = *scene.get_storage<std::string>();
+		auto string_at = [&](size_t i) -> const std::string& { return *(std::string*)strings.element(i); };
+		// Radix sort is stable (elements with equal keys stay in entity order, which is the order they were added in)...
+		strings.sort_by_key<std::string>(scene, [](const std::string& s, ecs::entity) { return s.size() % 2 == 0; });
+		for(size_t i = 1; i < count; ++i) {
+			bool previous = string_at(i - 1).size() % 2 == 0, current = string_at(i).size() % 2 == 0;
+			CHECK(previous <= current);
+			if(previous == current) CHECK(strings.entity_of(i - 1) < strings.entity_of(i));
+		}
+		strings.sort_by_key<std::string>(scene, [](const std::string& s, ecs::entity) { return s.size(); });
+		for(size_t i = 1; i < count; ++i) {
+			CHECK(string_at(i - 1).size() <= string_at(i).size());
+			if(string_at(i - 1).size() == string_at(i).size()) CHECK(strings.entity_of(i - 1) < strings.entity_of(i));
+		}
+		// ... and so is merge sort
+		strings.sort_by_key<std::string>(scene, [](const std::string& s, ecs::entity) { return s.substr(0, 1); });
+		for(size_t i = 1; i < count; ++i) {
+			CHECK(string_at(i - 1)[0] <= string_at(i)[0]);
+			if(string_at(i - 1)[0] == string_at(i)[0])
+				CHECK(std::pair{string_at(i - 1).size(), strings.entity_of(i - 1)} < std::pair{string_at(i).size(), strings.entity_of(i)});
+		}
+		strings.sort_by_value<std::string>(scene);
+		for(size_t i = 1; i < count; ++i)
+			CHECK(string_at(i - 1) <= string_at(i));
+		for(ecs::entity e = 0; e < count; ++e)
+			CHECK(*scene.get_component<std::string>(e) == std::to_string((e * 7919) % count));
+
+		// Force the parallel path even on machines with a single hardware thread
+		std::vector<size_t> order(count);
+		std::iota(order.rbegin(), order.rend(), 0);
+		ecs::detail::parallel_sort_indices(order, std::less<size_t>{}, 6);
+		CHECK(std::is_sorted(order.begin(), order.end()));
+	}
+
+	TEST_CASE("ECS::Benchmark::SortByKey" * doctest::skip()) {
+		ZoneScopedN("ECS::Benchmark::SortByKey");
+		constexpr size_t count = 1'000'000;
+		auto make_scene = [] {
+			ecs::scene scene;
+			scene.create_entities(count);
+			for(ecs::entity e = 0; e < count; ++e)
+				*scene.add_component<float>(e) = float((e * 7919) % count) - count / 2.f;
+			return scene;
+		};
+		{
+			auto scene = make_scene();
+			ZoneScopedN("ECS::Benchmark::SortByKey::comparator");
+			scene.get_storage<float>()->sort<float>(scene, [](float* a, float* b) { return *a < *b; });
+		}
+		{
+			auto scene = make_scene();
+			ZoneScopedN("ECS::Benchmark::SortByKey::radix");
+			scene.get_storage<float>()->sort_by_value<float>(scene);
+		}
+		{
+			auto scene = make_scene();
+			ZoneScopedN("ECS::Benchmark::SortByKey::merge");
+			scene.get_storage<float>()->sort_by_key<float>(scene, [](const float& f, ecs::entity) { return std::to_string(f); });
+		}
+		FrameMark;
+	}
+
+	struct swap_link {
+		ecs::entity target;
+		static void swap_entities(swap_link& l, ecs::entity a, ecs::entity b) {
+			if(l.target == a) l.target = b;
+			else if(l.target == b) l.target = a;
+		}
+	};
+	struct remap_link : public swap_link {
+		static void remap_entities(remap_link& l, std::span<const ecs::entity> remap) {
+			l.target = ecs::remap_entity(l.target, remap);
+		}
+	};
+
+	TEST_CASE("ECS::ReorderEntities") {
+		ZoneScoped;
+		static_assert(ecs::detail::has_remap_entities<remap_link> && !ecs::detail::has_remap_entities<swap_link>);
+		constexpr size_t count = 100;
+		for(auto mode: {ecs::storage_mode::sparse_set, ecs::storage_mode::archetype}) {
+			// Every entity links to the next one, then the order of the entities is reversed
+			ecs::scene swapped, remapped;
+			swapped.mode = remapped.mode = mode;
+			swapped.create_entities(count);
+			remapped.create_entities(count);
+			for(ecs::entity e = 0; e < count; ++e) {
+				swapped.add_component<swap_link>(e)->target = (e + 1) % count;
+				remapped.add_component<remap_link>(e)->target = (e + 1) % count;
+				if(e % 2) {
+					*swapped.add_component<float>(e) = e;
+					*remapped.add_component<float>(e) = e;
+				}
+			}
+			std::vector<size_t> order(count);
+			std::iota(order.rbegin(), order.rend(), 0);
+			swapped.reorder_entities<swap_link>(order);
+			remapped.reorder_entities<remap_link>(order);
+
+			// The single pass remap must produce the same scene as the chain of swaps
+			for(ecs::entity e = 0; e < count; ++e) {
+				ecs::entity old = count - 1 - e;
+				CHECK(swapped.get_component<swap_link>(e)->target == (count - 1 - (old + 1) % count));
+				CHECK(remapped.get_component<remap_link>(e)->target == swapped.get_component<swap_link>(e)->target);
+				CHECK(remapped.has_component<float>(e) == (old % 2 == 1));
+				CHECK(remapped.signature(e) == swapped.signature(e));
+				if(old % 2) CHECK(*remapped.get_component<float>(e) == old);
+			}
+		}
+	}
+
+	struct registered_link {
+		ecs::entity target;
+		static constexpr ecs::entity_fields entity_references{&registered_link::target};
+	};
+	struct registered_tree {
+		ecs::entity parent; std::vector<ecs::entity> children;
+		static constexpr ecs::entity_fields entity_references{&registered_tree::parent, &registered_tree::children};
+	};
+	struct registered_list : public std::vector<registered_link> {
+		static constexpr ecs::entity_fields entity_references{ecs::self_elements};
+	};
+
+	TEST_CASE("ECS::EntityReferences") {
+		ZoneScoped;
+		static_assert(ecs::detail::references_entities<registered_tree> && !ecs::detail::references_entities<swap_link>);
+		constexpr size_t count = 100;
+		for(auto mode: {ecs::storage_mode::sparse_set, ecs::storage_mode::archetype}) {
+			// Registered references are remapped without being listed (alongside a listed component which only knows how to swap)
+			ecs::scene scene;
+			scene.mode = mode;
+			scene.create_entities(count);
+			for(ecs::entity e = 0; e < count; ++e) {
+				scene.add_component<registered_link>(e)->target = (e + 1) % count;
+				*scene.add_component<registered_tree>(e) = {e / 2, {e * 2 % count, (e * 2 + 1) % count}};
+				scene.add_component<registered_list>(e)->push_back({(e + 3) % count});
+				scene.add_component<swap_link>(e)->target = (e + 1) % count;
+			}
+			std::vector<size_t> order(count);
+			std::iota(order.rbegin(), order.rend(), 0);
+			scene.reorder_entities<swap_link>(order);
+
+			auto moved = [](ecs::entity e) { return count - 1 - e; };
+			for(ecs::entity e = 0; e < count; ++e) {
+				ecs::entity old = moved(e);
+				CHECK(scene.get_component<registered_link>(e)->target == moved((old + 1) % count));
+				CHECK(scene.get_component<swap_link>(e)->target == moved((old + 1) % count));
+				auto& tree = *scene.get_component<registered_tree>(e);
+				CHECK(tree.parent == moved(old / 2));
+				CHECK(tree.children == std::vector<ecs::entity>{moved(old * 2 % count), moved((old * 2 + 1) % count)});
+				CHECK(scene.get_component<registered_list>(e)->front().target == moved((old + 3) % count));
+			}
+
+			// Single swaps keep registered references in sync as well
+			scene.swap_entities(0, 1);
+			CHECK(scene.get_component<registered_link>(1)->target == moved((moved(0) + 1) % count));
+			CHECK(scene.get_component<registered_link>(moved(moved(1) - 1))->target == 0);
+
+			// A list of swaps remaps the references once, ending up where swapping one at a time does
+			auto batched = scene;
+			std::vector<std::pair<ecs::entity, ecs::entity>> swaps = {{2, 3}, {3, 4}, {10, 2}, {50, 10}};
+			for(auto [a, b]: swaps) scene.swap_entities(a, b);
+			batched.swap_entities(swaps);
+			for(ecs::entity e = 0; e < count; ++e) {
+				CHECK(batched.get_component<registered_link>(e)->target == scene.get_component<registered_link>(e)->target);
+				CHECK(batched.get_component<registered_tree>(e)->children == scene.get_component<registered_tree>(e)->children);
+			}
+		}
+
+		// Storages constructed from a component (rather than by the scene) know how to remap it too
+		{
+			ecs::scene::component_storage storage(registered_link{});
+			CHECK(storage.remap_references != nullptr);
+		}
+	}
+
+	TEST_CASE("ECS::MakeMonotonic") {
+		ZoneScoped;
+		for(auto mode: {ecs::storage_mode::sparse_set, ecs::storage_mode::archetype}) {
+			ecs::scene scene;
+			scene.mode = mode;
+			constexpr size_t count = 100;
+			scene.create_entities(count);
+			for(ecs::entity e = count; e--; ) { // Added backwards so the storage starts out in reverse order
+				*scene.add_component<float>(e) = e;
+				if(e % 3 == 0) *scene.add_component<ecs::with_entity<double>>(e) = {double(e)};
+			}
+
+			// Reordering entities leaves the components where they were
+			std::vector<size_t> order(count);
+			std::iota(order.begin(), order.end(), 0);
+			std::reverse(order.begin(), order.end());
+			scene.reorder_entities(order);
+			scene.make_monotonic<float, ecs::with_entity<double>>();
+
+			if(mode == ecs::storage_mode::sparse_set) {
+				auto& storage = *scene.get_storage<float>();
+				for(size_t i = 0; i < count; ++i) {
+					CHECK(storage.entity_of(i) == i);
+					CHECK(*(float*)storage.element(i) == count - 1 - i);
+				}
+			} else for(auto& table: scene.archetypes)
+				CHECK(std::is_sorted(table.entities.begin(), table.entities.end()));
+			auto& doubles = *scene.get_storage<ecs::with_entity<double>>();
+			for(size_t i = 1; i < doubles.size(); ++i)
+				CHECK(doubles.entity_of(i - 1) < doubles.entity_of(i));
+			for(ecs::entity e = 0; e < count; ++e) {
+				CHECK(*scene.get_component<float>(e) == count - 1 - e);
+				CHECK(scene.has_component<ecs::with_entity<double>>(e) == ((count - 1 - e) % 3 == 0));
+			}
+		}
+	}
+
+	TEST_CASE("ECS::Compact") {
+		ZoneScoped;
+		ecs::scene scene;
+		auto a = scene.create_entity(), b = scene.create_entity(), c = scene.create_entity();
+		*scene.add_component<std::string>(c) = "c";
+		*scene.add_component<std::string>(b) = "b";
+		*scene.add_component<std::string>(a) = "a";
+		size_t modifications = scene.get_storage<std::string>()->modifications;
+		CHECK(scene.release_entity(b, false)); // Leaves b's string behind without an owner
+		CHECK(scene.get_storage<std::string>()->entity_of(1) == ecs::invalid_entity);
+		CHECK(scene.get_storage<std::string>()->modifications > modifications);
+		CHECK(scene.get_storage<std::string>()->owned_count() == 2);
+
+		scene.compact();
+		auto& storage = *scene.get_storage<std::string>();
+		CHECK(storage.size() == 2);
+		CHECK(*(std::string*)storage.element(0) == "a");
+		CHECK(*(std::string*)storage.element(1) == "c");
+		CHECK(*scene.get_component<std::string>(a) == "a");
+		CHECK(*scene.get_component<std::string>(c) == "c");
+	}
+
 	TEST_CASE("ECS::WithEntity") {
 		ZoneScoped;
 		ecs::scene scene;
@@ -191,6 +1124,126 @@ TEST_SUITE("ECS") {
 			CHECK(*hashtable.find(e) == e);
 			CHECK(get_key<int>(scene.get_component<C>(*hashtable.find(e))) == e);
 		}
+		CHECK(hashtable.occupied() == 100);
+
+		// Cells added after a rehash are inserted into the existing table...
+		for(size_t i = 0; i < 50; ++i) {
+			get_key_and_mark_occupied<int>(scene.add_component<C>(current)) = current;
+			current = scene.create_entity();
+		}
+		CHECK(hashtable.rehash(scene) == true);
+		CHECK(hashtable.occupied() == 150);
+		CHECK(hashtable.rehash(scene) == true); // Nothing changed
+		for(ecs::entity e = first; e < first + 150; ++e)
+			CHECK(*hashtable.find(e) == e);
+
+		// ... while removing cells forces the table to be rebuilt
+		for(ecs::entity e = first; e < first + 150; e += 10)
+			scene.remove_component<C>(e);
+		CHECK(hashtable.rehash(scene) == true);
+		CHECK(hashtable.occupied() == 135);
+		for(ecs::entity e = first; e < first + 150; ++e)
+			if((e - first) % 10) CHECK(*hashtable.find(e) == e);
+			else CHECK(!hashtable.find(e));
+	}
+
+	template<typename Hashtable>
+	void check_hashtable_insert_remove() {
+		using C = typename Hashtable::component_type;
+		ecs::scene scene;
+		auto& hashtable = *get_adapted_component_storage<Hashtable>(scene);
+		auto& storage = *scene.get_storage<C>();
+		constexpr size_t count = 2000;
+		ecs::entity first = scene.create_entities(count);
+
+		// Inserting keeps the scene up to date and never needs a rebuild before lookups
+		for(ecs::entity e = first; e < first + count; ++e)
+			CHECK(hashtable.insert(scene, e, int(e) * 7).has_value());
+		CHECK(!hashtable.insert(scene, first, int(first + 1) * 7).has_value()); // Already present
+		CHECK(hashtable.occupied() == count);
+		for(ecs::entity e = first; e < first + count; ++e) {
+			CHECK(scene.has_component<C>(e));
+			CHECK(*hashtable.find(int(e) * 7) == e);
+		}
+
+		// Removing keys (by key or by entity) takes the component away without moving any other cells
+		for(ecs::entity e = first; e < first + count; e += 2)
+			CHECK(hashtable.remove(scene, int(e) * 7));
+		CHECK(hashtable.erase(scene, first + 1));
+		CHECK(!hashtable.erase(scene, first + 1));
+		CHECK(!hashtable.remove(scene, int(first) * 7));
+		CHECK(hashtable.occupied() == count / 2 - 1);
+		for(ecs::entity e = first; e < first + count; ++e) {
+			bool present = (e - first) % 2 && e != first + 1;
+			CHECK(scene.has_component<C>(e) == present);
+			CHECK(hashtable.find(int(e) * 7).has_value() == present);
+			if(present) CHECK(get_key<int>(scene.get_component<C>(e)) == int(e) * 7);
+		}
+
+		// Churning keys reuses the emptied cells rather than growing the storage
+		size_t size = storage.size();
+		for(size_t round = 0; round < 10; ++round)
+			for(ecs::entity e = first; e < first + count; e += 2) {
+				CHECK(hashtable.insert(scene, e, -int(e * 16 + round + 1)).has_value());
+				CHECK(hashtable.erase(scene, e));
+			}
+		CHECK(storage.size() <= size + count / 10);
+		CHECK(hashtable.occupied() == count / 2 - 1);
+
+		// Reinserting with a new key for an entity replaces its old key
+		CHECK(hashtable.insert(scene, first + 3, -1).has_value());
+		CHECK(!hashtable.find(int(first + 3) * 7));
+		CHECK(*hashtable.find(-1) == first + 3);
+		CHECK(hashtable.occupied() == count / 2 - 1);
+	}
+
+	TEST_CASE("ECS::hashtable::insert_remove") {
+		ZoneScoped;
+		check_hashtable_insert_remove<ecs::hashtable::component_storage<int>>();
+		check_hashtable_insert_remove<ecs::hashtable::swiss::component_storage<int>>();
+	}
+
+	TEST_CASE("ECS::hashtable::swiss") {
+		ZoneScoped;
+		using Swiss = ecs::hashtable::swiss::component_storage<int>;
+		using C = Swiss::component_type;
+		static_assert(std::is_same_v<C, ecs::hashtable::component_storage<int>::component_type>); // Both tables share their cells
+
+		ecs::scene scene;
+		ecs::entity first = scene.create_entity();
+		ecs::entity current = first;
+		for(size_t i = 0; i < 1000; ++i) {
+			get_key_and_mark_occupied<int>(scene.add_component<C>(current)) = current;
+			current = scene.create_entity();
+		}
+
+		auto& hashtable = *get_adapted_component_storage<Swiss>(scene);
+		CHECK(hashtable.rehash(scene) == true);
+		CHECK(hashtable.occupied() == 1000);
+		CHECK(std::has_single_bit(scene.get_storage<C>()->adapter.capacity));
+		for(ecs::entity e = first; e < first + 1000; ++e) {
+			CHECK(*hashtable.find(e) == e);
+			CHECK(get_key<int>(scene.get_component<C>(*hashtable.find(e))) == e);
+		}
+		CHECK(!hashtable.find(-5));
+
+		// Adding cells (enough to grow the table) and removing keys
+		for(size_t i = 0; i < 1000; ++i) {
+			get_key_and_mark_occupied<int>(scene.add_component<C>(current)) = current;
+			current = scene.create_entity();
+		}
+		CHECK(hashtable.rehash(scene) == true);
+		for(ecs::entity e = first; e < first + 2000; e += 3)
+			CHECK(hashtable.remove(scene, e));
+		CHECK(hashtable.occupied() == 2000 - 667);
+		for(ecs::entity e = first; e < first + 2000; ++e)
+			if((e - first) % 3) CHECK(*hashtable.find(e) == e);
+			else CHECK(!hashtable.find(e));
+
+		// The same cells can be viewed as a hopscotch table (after it reorganizes them)
+		auto& hopscotch = *get_adapted_component_storage<ecs::hashtable::component_storage<int>>(scene);
+		CHECK(hopscotch.rehash(scene) == true);
+		CHECK(*hopscotch.find(first + 1) == first + 1);
 	}
 
 	TEST_CASE("ECS::UniqueTag") {
@@ -213,7 +1266,7 @@ TEST_SUITE("ECS") {
 			auto& storage = *scene.get_storage<float>();
 			storage.sort_monotonic<float>(scene);
 			// scene.make_monotonic();
-			float* storage_as_float = (float*)storage.data.data();
+			float* storage_as_float = (float*)storage.element(0);
 			CHECK(storage_as_float[0] == 3);
 			CHECK(*scene.get_component<float>(e0) == 3);
 			CHECK(storage_as_float[1] == 27);
@@ -227,7 +1280,7 @@ TEST_SUITE("ECS") {
 			auto& storage = *scene.get_storage<float, 1>();
 			storage.sort_monotonic<float, 1>(scene);
 			// scene.make_monotonic();
-			float* storage_as_float = (float*)storage.data.data();
+			float* storage_as_float = (float*)storage.element(0);
 			CHECK(storage_as_float[0] == 5);
 			CHECK(*scene.get_component<float, 1>(e0) == 5);
 			CHECK(storage_as_float[1] == 0);
@@ -87,7 +87,10 @@ namespace calculator {
 		// start ::= expressions
 		bool start(doir::ParseModule& module) {
 			ZoneScoped;
-			if(module.lexer_state.lexeme.empty()) module.lex(lexer);
+			if(module.lexer_state.lexeme.empty()) {
+				module.reserve_for_tokens();
+				module.lex(lexer);
+			}
 			return !module.has_attribute<doir::Error>(expressions(module));
 		}
 
@@ -271,7 +274,7 @@ TEST_CASE("Calculator::REPL" * doctest::skip()) {
 	while(std::getline(nowide::cin, temp)) {
 		if(temp == "\\q") break;
 
-		module.buffer = module.buffer + temp + "\n";
+		module.buffer += temp + "\n";
 		module.lexer_state.lexeme = {};
 		module.lexer_state.remaining = std::string_view{module.buffer}.substr(start);
 		start = module.buffer.size();
@@ -0,0 +1,150 @@
+#include "../fnv1a.hpp"
+#include "../wyhash.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#include "tests.utils.hpp"
+
+TEST_SUITE("Hash") {
+	// Every length up to a few of the 48 byte blocks, so each branch of hash_bytes is covered
+	constexpr size_t max_length = 200;
+	constexpr std::array<char, max_length> pattern = []{
+		std::array<char, max_length> out{};
+		for(size_t i = 0; i < max_length; ++i) out[i] = char(i * 31 + 7);
+		return out;
+	}();
+	constexpr std::array<uint64_t, max_length + 1> compile_time_hashes = []{
+		std::array<uint64_t, max_length + 1> out{};
+		for(size_t length = 0; length <= max_length; ++length)
+			out[length] = wyhash::hash_bytes(pattern.data(), length);
+		return out;
+	}();
+
+	TEST_CASE("Hash::constexpr") {
+		ZoneScoped;
+		static_assert(wyhash::wyhash_64<std::string_view>{}("identifier") != wyhash::wyhash_64<std::string_view>{}("identifiez"));
+		static_assert(wyhash::wyhash_64<uint32_t>{}(5) == wyhash::hash_integer(5));
+
+		// Compile time and run time hashing must agree (the runtime path reads whole words instead of bytes)
+		std::vector<char> runtime(pattern.begin(), pattern.end());
+		for(size_t length = 0; length <= max_length; ++length)
+			CHECK(wyhash::hash_bytes(runtime.data(), length) == compile_time_hashes[length]);
+		std::string_view view{runtime.data(), 20};
+		CHECK(wyhash::wyhash_64<std::string_view>{}(view) == compile_time_hashes[20]);
+		CHECK(wyhash::wyhash_64<std::string>{}(std::string{view}) == compile_time_hashes[20]);
+		CHECK(wyhash::wyhash_64<std::span<std::byte>>{}({(std::byte*)runtime.data(), 20}) == compile_time_hashes[20]);
+	}
+
+	TEST_CASE("Hash::distinct") {
+		ZoneScoped;
+		// Every prefix length hashes differently
+		std::vector<uint64_t> hashes(compile_time_hashes.begin(), compile_time_hashes.end());
+		std::sort(hashes.begin(), hashes.end());
+		CHECK(std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end());
+
+		// Flipping any single bit changes the hash, and changes about half of its bits
+		std::array<char, 64> buffer = {};
+		uint64_t base = wyhash::hash_bytes(buffer.data(), buffer.size());
+		size_t flipped = 0;
+		for(size_t bit = 0; bit < buffer.size() * 8; ++bit) {
+			buffer[bit / 8] ^= char(1 << (bit % 8));
+			uint64_t hash = wyhash::hash_bytes(buffer.data(), buffer.size());
+			CHECK(hash != base);
+			flipped += std::popcount(hash ^ base);
+			buffer[bit / 8] ^= char(1 << (bit % 8));
+		}
+		double average = double(flipped) / (buffer.size() * 8);
+		CHECK(average > 28);
+		CHECK(average < 36);
+
+		// Seeds and combine order matter
+		CHECK(wyhash::hash_bytes("x", 1, 1) != wyhash::hash_bytes("x", 1, 2));
+		CHECK(wyhash::combine(1, 2) != wyhash::combine(2, 1));
+		CHECK(wyhash::combine(7, 7) != 0);
+
+		// Values are hashed by value
+		CHECK(wyhash::wyhash_64<double>{}(-0.0) == wyhash::wyhash_64<double>{}(0.0));
+		CHECK(wyhash::wyhash_64<uint8_t>{}(3) == wyhash::wyhash_64<uint64_t>{}(3));
+		enum class E : int { A, B };
+		CHECK(wyhash::wyhash_64<E>{}(E::B) == wyhash::hash_integer(1));
+	}
+
+	// Generates identifier like strings (v0, v1, ... or longer names sharing a prefix)
+	std::vector<std::string> identifiers(size_t count, std::string_view prefix = "v") {
+		std::vector<std::string> out;
+		out.reserve(count);
+		for(size_t i = 0; i < count; ++i)
+			out.emplace_back(std::string{prefix} + std::to_string(i));
+		return out;
+	}
+
+	// Counts how many keys land in an already occupied bucket of a power of two table
+	template<typename Hash>
+	size_t bucket_collisions(const std::vector<std::string>& keys, size_t buckets) {
+		std::vector<bool> used(buckets);
+		size_t collisions = 0;
+		for(auto& key: keys) {
+			size_t bucket = Hash{}(key) & (buckets - 1);
+			collisions += used[bucket];
+			used[bucket] = true;
+		}
+		return collisions;
+	}
+
+	TEST_CASE("Hash::collisions") {
+		ZoneScoped;
+		constexpr size_t count = 100'000, buckets = 1 << 17;
+		auto keys = identifiers(count);
+		std::vector<uint64_t> hashes;
+		for(auto& key: keys) hashes.push_back(wyhash::wyhash_64<std::string>{}(key));
+		std::sort(hashes.begin(), hashes.end());
+		CHECK(std::adjacent_find(hashes.begin(), hashes.end()) == hashes.end());
+
+		// A random function puts n keys into m buckets with about n - m(1 - e^(-n/m)) collisions
+		double expected = count - buckets * (1 - std::exp(-double(count) / buckets));
+		size_t collisions = bucket_collisions<wyhash::wyhash_64<std::string>>(keys, buckets);
+		CHECK(collisions > expected * 0.9);
+		CHECK(collisions < expected * 1.1);
+	}
+
+	TEST_CASE("Hash::Benchmark::collisions" * doctest::skip()) {
+		ZoneScopedN("Hash::Benchmark::collisions");
+		constexpr size_t count = 1'000'000;
+		for(std::string_view prefix: {"v", "a_much_longer_identifier_shared_by_every_key_", "x"}) {
+			auto keys = identifiers(count, prefix);
+			for(size_t buckets: {size_t(1) << 20, size_t(1) << 21}) {
+				double expected = count - buckets * (1 - std::exp(-double(count) / buckets));
+				size_t fnv = bucket_collisions<fnv::fnv1a_64<std::string>>(keys, buckets);
+				size_t wy = bucket_collisions<wyhash::wyhash_64<std::string>>(keys, buckets);
+				MESSAGE("\"" << prefix << "N\" keys into " << buckets << " buckets: fnv1a " << fnv << " collisions, wyhash " << wy << " (random " << size_t(expected) << ")");
+			}
+		}
+		FrameMark;
+	}
+
+	TEST_CASE("Hash::Benchmark::throughput" * doctest::skip()) {
+		ZoneScopedN("Hash::Benchmark::throughput");
+		constexpr size_t total = 256 << 20; // Bytes hashed per size
+		std::vector<char> data(1 << 16);
+		for(size_t i = 0; i < data.size(); ++i) data[i] = char(i * 131 + 17);
+
+		auto time = [&](auto hash, size_t length) {
+			uint64_t sink = 0;
+			size_t iterations = total / length, stride = data.size() - length;
+			auto start = std::chrono::steady_clock::now();
+			for(size_t i = 0; i < iterations; ++i)
+				sink += hash(std::string_view{data.data() + (i * 64) % stride, length});
+			double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			CHECK(sink != 0);
+			return total / seconds / (1 << 20);
+		};
+		for(size_t length: {4, 8, 16, 32, 64, 256, 4096}) {
+			double fnv = time(fnv::fnv1a_64<std::string_view>{}, length);
+			double wy = time(wyhash::wyhash_64<std::string_view>{}, length);
+			MESSAGE(length << " byte keys: fnv1a " << size_t(fnv) << "MB/s, wyhash " << size_t(wy) << "MB/s");
+		}
+		FrameMark;
+	}
+}
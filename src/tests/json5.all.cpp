@@ -64,7 +64,10 @@ namespace json5 {
 		// Start ::= Value
 		doir::Token start(doir::ParseModule& module) {
 			ZoneScoped;
-			if(module.lexer_state.lexeme.empty()) module.lex(lexer);
+			if(module.lexer_state.lexeme.empty()) {
+				module.reserve_for_tokens();
+				module.lex(lexer);
+			}
 			return value(module);
 		}
 
@@ -194,17 +197,17 @@ namespace json5 {
 	};
 }
 
-namespace fnv {
+namespace wyhash {
 	template<>
-	struct fnv1a_64<json5::parse::ObjectMember> {
-		inline uint64_t operator()(const json5::parse::ObjectMember& mem) {
-			return fnv1a_64<std::string_view>{}(mem.value) ^ fnv1a_64<doir::Token>{}(mem.entity);
+	struct wyhash_64<json5::parse::ObjectMember> {
+		inline uint64_t operator()(const json5::parse::ObjectMember& mem) const {
+			return combine(wyhash_64<std::string_view>{}(mem.value), wyhash_64<doir::Token>{}(mem.entity));
 		}
 	};
 	template<>
-	struct fnv1a_64<json5::parse::ArrayMember> {
-		inline uint64_t operator()(const json5::parse::ArrayMember& mem) {
-			return fnv1a_64<size_t>{}(mem.value) ^ fnv1a_64<doir::Token>{}(mem.entity);
+	struct wyhash_64<json5::parse::ArrayMember> {
+		inline uint64_t operator()(const json5::parse::ArrayMember& mem) const {
+			return combine(wyhash_64<size_t>{}(mem.value), wyhash_64<doir::Token>{}(mem.entity));
 		}
 	};
 }
@@ -402,6 +405,98 @@ TEST_CASE("JSON5::nested_object") {
 	FrameMark;
 }
 
+TEST_CASE("JSON5::statistics") {
+	doir::ParseModule module("{x: [1, 2, 3], y: \"hello\"}");
+	json5::parse p;
+	p.start(module);
+	auto stats = module.statistics();
+	auto doubles = std::ranges::find(stats.storages, ecs::get_global_component_id<double>(), &ecs::scene::storage_statistics::component_id);
+	REQUIRE(doubles != stats.storages.end());
+	CHECK(doubles->name == ecs::get_global_component_name(doubles->component_id));
+	CHECK(doubles->element_count == 3);
+	CHECK(doubles->element_size == sizeof(double));
+	CHECK(doubles->capacity_bytes >= 3 * sizeof(double));
+	CHECK(doubles->fragmentation() < 1);
+	CHECK(stats.entity_component_indices_bytes > 0);
+	CHECK(stats.total_bytes() > stats.component_bytes);
+	module.plot_statistics();
+	FrameMark;
+}
+
+TEST_CASE("JSON5::memory_resource") {
+	std::pmr::unsynchronized_pool_resource pool;
+	doir::ParseModule module("{x: 5}", {}, doir::default_storage_mode, &pool);
+	json5::parse p;
+	doir::Token root = p.start(module);
+	CHECK(module.resource() == &pool);
+	CHECK(module.buffer.get_allocator().resource() == &pool);
+	auto& hashtable = *module.get_hashtable<json5::parse::ObjectMember>();
+	doir::Token x = module.get_attribute<doir::TokenReference>(*hashtable.find({"x", root}))->token();
+	CHECK(*module.get_attribute<double>(x) == 5);
+
+	doir::ParseModule owned("{}"); // Modules default to their own pool
+	CHECK(owned.resource() != std::pmr::get_default_resource());
+	CHECK(dynamic_cast<std::pmr::unsynchronized_pool_resource*>(owned.resource()));
+
+	// Arenas can be opted into for modules which are compiled once
+	std::pmr::monotonic_buffer_resource arena;
+	doir::ParseModule once("{x: 5}", {}, doir::default_storage_mode, &arena);
+	CHECK(json5::parse{}.start(once) != 0);
+	CHECK(once.resource() == &arena);
+	FrameMark;
+}
+
+TEST_CASE("JSON5::snapshot") {
+	doir::ParseModule module("{x: 5, y: [1, 2, 3]}");
+	json5::parse p;
+	doir::Token root = p.start(module);
+	auto x = [&] {
+		auto& hashtable = *module.get_hashtable<json5::parse::ObjectMember>();
+		return module.get_attribute<doir::TokenReference>(*hashtable.find({"x", root}))->token();
+	};
+	size_t tokens = module.token_count();
+
+	auto snapshot = module.take_snapshot();
+	*module.get_attribute<double>(x()) = 6;
+	module.add_attribute<double>(module.make_token()) = 7;
+	module.buffer += "// speculative";
+	CHECK(*module.get_attribute<double>(x()) == 6);
+
+	module.restore(snapshot);
+	CHECK(module.token_count() == tokens);
+	CHECK(*module.get_attribute<double>(x()) == 5);
+	CHECK(module.buffer == "{x: 5, y: [1, 2, 3]}");
+	FrameMark;
+}
+
+TEST_CASE("JSON5::snapshot (threaded)") {
+	// Saving pages allocates from the module's pool, which several threads writing at once must not race on
+	constexpr size_t count = 4 * ecs::scene::component_storage::elements_per_page;
+	auto text = [](size_t i) { return "a string long enough to not fit in the small string buffer " + std::to_string(i); };
+	doir::Module module;
+	for(size_t i = 0; i < count; ++i) {
+		doir::Token t = module.make_token();
+		module.add_attribute<double>(t) = i;
+		module.add_attribute<std::pmr::string>(t) = text(i);
+	}
+
+	auto snapshot = module.take_snapshot();
+	doir::par_for_each<double, std::pmr::string>(module, [](auto tuple) {
+		auto& [number, string] = tuple;
+		number = -number;
+		string[0] = 'A'; // Modified in place, so only saving the pages allocates
+	}, 16, 4);
+	CHECK(*module.get_attribute<double>(1) == -0.0);
+	CHECK(module.get_attribute<std::pmr::string>(1)->front() == 'A');
+
+	module.restore(snapshot);
+	for(doir::Token t = 1; t <= count; ++t) {
+		CHECK(*module.get_attribute<double>(t) == t - 1);
+		CHECK(std::string_view(*module.get_attribute<std::pmr::string>(t)) == text(t - 1));
+	}
+	FrameMark;
+}
+
 // TEST_CASE("JSON5::1k" /* * doctest::skip()*/) {
 // 	doir::ParseModule module(
 // #include "random_data.json"
@@ -75,37 +75,22 @@ namespace lox {
 
 	inline Type token_type(doir::Module& module, doir::Token t) {
 		ZoneScoped;
-		if(module.has_attribute<lox::comp::Variable>(t)) return Type::Variable;
-		else if(module.has_attribute<lox::comp::Function>(t)) return Type::Call;
-		else if(module.has_hashtable_attribute<lox::comp::VariableDeclaire>(t)) return Type::VariableDeclaire;
-		else if(module.has_hashtable_attribute<lox::comp::FunctionDeclaire>(t)) return Type::FunctionDeclaire;
-		else if(module.has_hashtable_attribute<lox::comp::ParameterDeclaire>(t)) return Type::ParameterDeclaire;
-		else if(module.has_attribute<lox::comp::BodyMarker>(t)) return Type::BodyMarker;
-		else if(module.has_attribute<lox::comp::Not>(t)) return Type::Not;
-		else if(module.has_attribute<lox::comp::Negate>(t)) return Type::Negate;
-		else if(module.has_attribute<lox::comp::Divide>(t)) return Type::Divide;
-		else if(module.has_attribute<lox::comp::Multiply>(t)) return Type::Multiply;
-		else if(module.has_attribute<lox::comp::Add>(t)) return Type::Add;
-		else if(module.has_attribute<lox::comp::Subtract>(t)) return Type::Subtract;
-		else if(module.has_attribute<lox::comp::LessThan>(t)) return Type::LessThan;
-		else if(module.has_attribute<lox::comp::LessThanEqualTo>(t)) return Type::LessThanEqualTo;
-		else if(module.has_attribute<lox::comp::GreaterThan>(t)) return Type::GreaterThan;
-		else if(module.has_attribute<lox::comp::GreaterThanEqualTo>(t)) return Type::GreaterThanEqualTo;
-		else if(module.has_attribute<lox::comp::EqualTo>(t)) return Type::EqualTo;
-		else if(module.has_attribute<lox::comp::NotEqualTo>(t)) return Type::NotEqualTo;
-		else if(module.has_attribute<lox::comp::And>(t)) return Type::And;
-		else if(module.has_attribute<lox::comp::Or>(t)) return Type::Or;
-		else if(module.has_attribute<lox::comp::Assign>(t)) return Type::Assign;
-		else if(module.has_attribute<lox::comp::Print>(t)) return Type::Print;
-		else if(module.has_attribute<lox::comp::Return>(t)) return Type::Return;
-		else if(module.has_attribute<lox::comp::While>(t)) return Type::While;
-		else if(module.has_attribute<lox::comp::If>(t)) return Type::If;
-		else if(module.has_attribute<lox::comp::Block>(t)) return Type::Block; // This check needs to happen after other types which might have blocks
-		else if(module.has_attribute<lox::comp::Null>(t)) return Type::Null;
-		else if(module.has_attribute<lox::comp::String>(t)) return Type::String;
-		else if(module.has_attribute<bool>(t)) return Type::Boolean;
-		else if(module.has_attribute<double>(t)) return Type::Number;
-		else return Type::Invalid;
+		// NOTE: Order matters, operations also store their runtime values and blocks can be attached to other statements
+		static constexpr Type types[] = {
+			Type::Variable, Type::Call, Type::VariableDeclaire, Type::FunctionDeclaire, Type::ParameterDeclaire, Type::BodyMarker,
+			Type::Not, Type::Negate, Type::Divide, Type::Multiply, Type::Add, Type::Subtract,
+			Type::LessThan, Type::LessThanEqualTo, Type::GreaterThan, Type::GreaterThanEqualTo, Type::EqualTo, Type::NotEqualTo,
+			Type::And, Type::Or, Type::Assign, Type::Print, Type::Return, Type::While, Type::If,
+			Type::Block, Type::Null, Type::String, Type::Boolean, Type::Number,
+			Type::Invalid // None of the above
+		};
+		return types[module.first_attribute_of<
+			lox::comp::Variable, lox::comp::Function, lox::comp::VariableDeclaire, lox::comp::FunctionDeclaire, lox::comp::ParameterDeclaire, lox::comp::BodyMarker,
+			lox::comp::Not, lox::comp::Negate, lox::comp::Divide, lox::comp::Multiply, lox::comp::Add, lox::comp::Subtract,
+			lox::comp::LessThan, lox::comp::LessThanEqualTo, lox::comp::GreaterThan, lox::comp::GreaterThanEqualTo, lox::comp::EqualTo, lox::comp::NotEqualTo,
+			lox::comp::And, lox::comp::Or, lox::comp::Assign, lox::comp::Print, lox::comp::Return, lox::comp::While, lox::comp::If,
+			lox::comp::Block, lox::comp::Null, lox::comp::String, bool, double
+		>(t)];
 	}
 }
 
@@ -1,8 +1,10 @@
 #include "lox.hpp"
+#include <atomic>
 #include <chrono>
 #include <cmath>
 #include <sstream>
 #include <string>
+#include <thread>
 #ifdef LOX_PERFORMANT_PRINTING
 	#include <print>
 #endif
@@ -31,9 +33,11 @@ Tcomponent& get_or_add(doir::Module& module, doir::Token t) {
 	return module.add_attribute<Tcomponent>(t);
 }
 
-inline std::string get_token_string(doir::Module& module, doir::Token str) {
+// NOTE: The view is invalidated if string attributes are added or removed, copy it first if that will happen before it is used
+inline std::string_view get_token_string(doir::Module& module, doir::Token str) {
 	ZoneScoped;
-	return module.has_attribute<std::string>(str) ? *module.get_attribute<std::string>(str) : std::string(module.get_attribute<doir::Lexeme>(str)->view(module.buffer));
+	if(auto string = module.get_attribute<std::string>(str); string) return *string;
+	return module.get_attribute<doir::Lexeme>(str)->view(module.buffer);
 }
 
 void dbg_print(doir::Module& module, doir::Token t) {
@@ -83,7 +87,10 @@ void copy_runtime_value(doir::Module& module, doir::Token dest, doir::Token sour
 	break; case lox::Type::String:
 		get_or_add<runtime_value_type>(module, dest).type = lox::Type::String;
 		get_or_add<lox::comp::String>(module, dest);
-		get_or_add<std::string>(module, dest) = get_token_string(module, source);
+		{
+			auto value = std::string(get_token_string(module, source)); // Copied before adding the attribute, which may move the source's string
+			get_or_add<std::string>(module, dest) = std::move(value);
+		}
 	break; default:
 		get_or_add<runtime_value_type>(module, dest).type = lox::Type::Null;
 		get_or_add<lox::comp::Null>(module, dest);
@@ -122,7 +129,7 @@ bool is_equal(doir::Module& module, doir::Token a, doir::Token b) {
 
 bool interpret_add(doir::Module& module, doir::Token add) {
 	ZoneScoped;
-	auto& op = *module.get_attribute<lox::comp::Operation>(add);
+	auto op = *module.get_attribute<lox::comp::Operation>(add);
 	if(module.has_attribute<double>(op.left) && module.has_attribute<double>(op.right)) {
 		get_or_add<runtime_value_type>(module, add).type = lox::Type::Number;
 		get_or_add<double>(module, add) = *module.get_attribute<double>(op.left) + *module.get_attribute<double>(op.right);
@@ -130,7 +137,9 @@ bool interpret_add(doir::Module& module, doir::Token add) {
 	} else if(module.has_attribute<lox::comp::String>(op.left) && module.has_attribute<lox::comp::String>(op.right)) {
 		get_or_add<runtime_value_type>(module, add).type = lox::Type::String;
 		get_or_add<lox::comp::String>(module, add);
-		get_or_add<std::string>(module, add) = get_token_string(module, op.left) + get_token_string(module, op.right);
+		auto value = std::string(get_token_string(module, op.left));
+		value += get_token_string(module, op.right);
+		get_or_add<std::string>(module, add) = std::move(value);
 		return true;
 	}
 	if(auto left = value_type(module, op.left), right = value_type(module, op.right); left != right)
@@ -141,7 +150,7 @@ bool interpret_add(doir::Module& module, doir::Token add) {
 
 bool interpret_subtract(doir::Module& module, doir::Token sub) {
 	ZoneScoped;
-	auto& op = *module.get_attribute<lox::comp::Operation>(sub);
+	auto op = *module.get_attribute<lox::comp::Operation>(sub);
 	if(module.has_attribute<double>(op.left) && module.has_attribute<double>(op.right)) {
 		get_or_add<runtime_value_type>(module, sub).type = lox::Type::Number;
 		get_or_add<double>(module, sub) = *module.get_attribute<double>(op.left) - *module.get_attribute<double>(op.right);
@@ -155,7 +164,7 @@ bool interpret_subtract(doir::Module& module, doir::Token sub) {
 
 bool interpret_multiply(doir::Module& module, doir::Token mult) {
 	ZoneScoped;
-	auto& op = *module.get_attribute<lox::comp::Operation>(mult);
+	auto op = *module.get_attribute<lox::comp::Operation>(mult);
 	if(module.has_attribute<double>(op.left) && module.has_attribute<double>(op.right)) {
 		get_or_add<runtime_value_type>(module, mult).type = lox::Type::Number;
 		get_or_add<double>(module, mult) = *module.get_attribute<double>(op.left) * *module.get_attribute<double>(op.right);
@@ -169,7 +178,7 @@ bool interpret_multiply(doir::Module& module, doir::Token mult) {
 
 bool interpret_divide(doir::Module& module, doir::Token div) {
 	ZoneScoped;
-	auto& op = *module.get_attribute<lox::comp::Operation>(div);
+	auto op = *module.get_attribute<lox::comp::Operation>(div);
 	if(module.has_attribute<double>(op.left) && module.has_attribute<double>(op.right)) {
 		get_or_add<runtime_value_type>(module, div).type = lox::Type::Number;
 		auto denom = *module.get_attribute<double>(op.right);
@@ -186,7 +195,7 @@ bool interpret_divide(doir::Module& module, doir::Token div) {
 
 bool interpret_less(doir::Module& module, doir::Token less) {
 	ZoneScoped;
-	auto& op = *module.get_attribute<lox::comp::Operation>(less);
+	auto op = *module.get_attribute<lox::comp::Operation>(less);
 	if(module.has_attribute<double>(op.left) && module.has_attribute<double>(op.right)) {
 		get_or_add<runtime_value_type>(module, less).type = lox::Type::Boolean;
 		get_or_add<bool>(module, less) = *module.get_attribute<double>(op.left) < *module.get_attribute<double>(op.right);
@@ -200,7 +209,7 @@ bool interpret_less(doir::Module& module, doir::Token less) {
 
 bool interpret_less_equal(doir::Module& module, doir::Token less) {
 	ZoneScoped;
-	auto& op = *module.get_attribute<lox::comp::Operation>(less);
+	auto op = *module.get_attribute<lox::comp::Operation>(less);
 	if(module.has_attribute<double>(op.left) && module.has_attribute<double>(op.right)) {
 		get_or_add<runtime_value_type>(module, less).type = lox::Type::Boolean;
 		get_or_add<bool>(module, less) = *module.get_attribute<double>(op.left) <= *module.get_attribute<double>(op.right);
@@ -214,7 +223,7 @@ bool interpret_less_equal(doir::Module& module, doir::Token less) {
 
 bool interpret_greater(doir::Module& module, doir::Token greater) {
 	ZoneScoped;
-	auto& op = *module.get_attribute<lox::comp::Operation>(greater);
+	auto op = *module.get_attribute<lox::comp::Operation>(greater);
 	if(module.has_attribute<double>(op.left) && module.has_attribute<double>(op.right)) {
 		get_or_add<runtime_value_type>(module, greater).type = lox::Type::Boolean;
 		get_or_add<bool>(module, greater) = *module.get_attribute<double>(op.left) > *module.get_attribute<double>(op.right);
@@ -228,7 +237,7 @@ bool interpret_greater(doir::Module& module, doir::Token greater) {
 
 bool interpret_greater_equal(doir::Module& module, doir::Token greater) {
 	ZoneScoped;
-	auto& op = *module.get_attribute<lox::comp::Operation>(greater);
+	auto op = *module.get_attribute<lox::comp::Operation>(greater);
 	if(module.has_attribute<double>(op.left) && module.has_attribute<double>(op.right)) {
 		get_or_add<runtime_value_type>(module, greater).type = lox::Type::Boolean;
 		get_or_add<bool>(module, greater) = *module.get_attribute<double>(op.left) >= *module.get_attribute<double>(op.right);
@@ -242,7 +251,7 @@ bool interpret_greater_equal(doir::Module& module, doir::Token greater) {
 
 bool interpret_negate(doir::Module& module, doir::Token neg) {
 	ZoneScoped;
-	auto& op = *module.get_attribute<lox::comp::Operation>(neg);
+	auto op = *module.get_attribute<lox::comp::Operation>(neg);
 	if(module.has_attribute<double>(op.left)) {
 		get_or_add<runtime_value_type>(module, neg).type = lox::Type::Number;
 		get_or_add<double>(module, neg) = -*module.get_attribute<double>(op.left);
@@ -254,7 +263,7 @@ bool interpret_negate(doir::Module& module, doir::Token neg) {
 
 bool interpret_not(doir::Module& module, doir::Token Not) {
 	ZoneScoped;
-	auto& op = *module.get_attribute<lox::comp::Operation>(Not);
+	auto op = *module.get_attribute<lox::comp::Operation>(Not);
 	get_or_add<runtime_value_type>(module, Not).type = lox::Type::Boolean;
 	get_or_add<bool>(module, Not) = !is_truthy(module, op.left);
 	return true;
@@ -262,7 +271,7 @@ bool interpret_not(doir::Module& module, doir::Token Not) {
 
 bool interpret_equal(doir::Module& module, doir::Token eq) {
 	ZoneScoped;
-	auto& op = *module.get_attribute<lox::comp::Operation>(eq);
+	auto op = *module.get_attribute<lox::comp::Operation>(eq);
 	get_or_add<runtime_value_type>(module, eq).type = lox::Type::Boolean;
 	get_or_add<bool>(module, eq) = is_equal(module, op.left, op.right);
 	return true;
@@ -270,7 +279,7 @@ bool interpret_equal(doir::Module& module, doir::Token eq) {
 
 bool interpret_not_equal(doir::Module& module, doir::Token eq) {
 	ZoneScoped;
-	auto& op = *module.get_attribute<lox::comp::Operation>(eq);
+	auto op = *module.get_attribute<lox::comp::Operation>(eq);
 	get_or_add<runtime_value_type>(module, eq).type = lox::Type::Boolean;
 	get_or_add<bool>(module, eq) = !is_equal(module, op.left, op.right);
 	return true;
@@ -278,7 +287,7 @@ bool interpret_not_equal(doir::Module& module, doir::Token eq) {
 
 bool interpret_print(doir::Module& module, doir::Token print) {
 	ZoneScoped;
-	auto& op = *module.get_attribute<lox::comp::Operation>(print);
+	auto op = *module.get_attribute<lox::comp::Operation>(print);
 	switch (value_type(module, op.left)) {
 	break; case lox::Type::Null:
 #ifdef LOX_PERFORMANT_PRINTING
@@ -561,6 +570,59 @@ true
 	FrameMark;
 }
 
+TEST_CASE("Lox::Interp::ArchetypeStorage") {
+	ZoneScopedN("Lox::Interp::ArchetypeStorage");
+	CAPTURE_CONSOLE_BEGIN
+		doir::ParseModule module("fun check(x) { print nil == x; } for(var i = 0; i < 3; i = i + 1) print (i + 1) * -6; print \"Hello \" + \"world\" + \"!\"; check(5); check(nil);", {}, ecs::storage_mode::archetype);
+		REQUIRE(module.storage_mode() == ecs::storage_mode::archetype);
+		auto root = lox::parse{}.start(module);
+		REQUIRE(root != 0);
+		canonicalize(module, root, false);
+		REQUIRE(verify_references(module));
+		REQUIRE(verify_redeclarations(module));
+		REQUIRE(verify_call_arrities(module));
+		REQUIRE(identify_trailing_calls(module));
+
+		REQUIRE(interpret(module));
+	CAPTURE_CONSOLE_END
+#ifndef LOX_PERFORMANT_PRINTING
+	CHECK(capture.str() == R"(-6
+-12
+-18
+Hello world!
+false
+true
+)");
+#endif
+	FrameMark;
+}
+
+TEST_CASE("Lox::Interp::Concurrent") {
+	ZoneScopedN("Lox::Interp::Concurrent");
+	constexpr size_t thread_count = 8, modules_per_thread = 16;
+	std::atomic<size_t> succeeded = 0;
+	std::vector<std::thread> threads;
+	for(size_t i = 0; i < thread_count; ++i)
+		threads.emplace_back([&succeeded, i] {
+			for(size_t j = 0; j < modules_per_thread; ++j) {
+				// Each module declares differently named variables and functions so that every module's declaration indices differ
+				std::string suffix = std::to_string(i) + "_" + std::to_string(j), n = std::to_string(i + j);
+				doir::ParseModule module("fun add" + suffix + "(a, b) { var tmp = a; a = b; b = tmp; return a + b; }"
+					" var fib" + suffix + " = 0; var next" + suffix + " = 1; for(var k = 0; k < " + n + "; k = k + 1) { var tmp = next" + suffix + "; next" + suffix + " = add" + suffix + "(fib" + suffix + ", next" + suffix + "); fib" + suffix + " = tmp; }");
+				auto root = lox::parse{}.start(module);
+				if(root == 0) continue;
+				canonicalize(module, root, false);
+				if(!verify_references(module) || !verify_redeclarations(module) || !verify_call_arrities(module) || !identify_trailing_calls(module))
+					continue;
+				if(interpret(module)) ++succeeded;
+			}
+		});
+	for(auto& thread: threads)
+		thread.join();
+	CHECK(succeeded == thread_count * modules_per_thread);
+	FrameMark;
+}
+
 TEST_CASE("Lox::Interp::UseBeforeDefine") {
 	ZoneScopedN("Lox::Interp::UseBeforeDefine");
 	CAPTURE_ERROR_CONSOLE_BEGIN CAPTURE_CONSOLE_BEGIN
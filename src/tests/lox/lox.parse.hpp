@@ -108,86 +108,47 @@ namespace lox {
 
 		struct Block {
 			doir::Token parent; std::vector<doir::Token> children;
-			static void swap_entities(Block& b, ecs::entity eA, ecs::entity eB) {
-				if(b.parent == eA) b.parent = eB;
-				else if(b.parent == eB) b.parent = eA;
-
-				for(auto& child: b.children)
-					if(child == eA) child = eB;
-					else if(child == eB) child = eA;
-			}
+			static constexpr ecs::entity_fields entity_references{&Block::parent, &Block::children};
 		};
 		using Call = Block; // TODO: How bad of an idea is it for calls to reuse block's storage?
 		struct TrailingCall {};
 
 		struct VariableDeclaire {
 			doir::Lexeme name;
+			doir::SymbolId symbol;
 			doir::Token parent; // Parent block
-			bool operator==(const VariableDeclaire& o) const {
-				return parent == o.parent && name.view(doir::hash_lookup_module->buffer)
-					== o.name.view(doir::hash_lookup_module->buffer);
-			}
-			static void swap_entities(VariableDeclaire& decl, ecs::entity eA, ecs::entity eB) {
-				if(decl.parent == eA) decl.parent = eB;
-				else if(decl.parent == eB) decl.parent = eA;
-			}
+			bool operator==(const VariableDeclaire& o) const { return parent == o.parent && symbol == o.symbol; }
+			static constexpr ecs::entity_fields entity_references{&VariableDeclaire::parent};
 		};
 		struct FunctionDeclaire {
 			doir::Lexeme name;
+			doir::SymbolId symbol;
 			doir::Token parent; // Parent block
-			bool operator==(const FunctionDeclaire& o) const {
-				return parent == o.parent && name.view(doir::hash_lookup_module->buffer)
-					== o.name.view(doir::hash_lookup_module->buffer);
-			}
-			static void swap_entities(FunctionDeclaire& decl, ecs::entity eA, ecs::entity eB) {
-				if(decl.parent == eA) decl.parent = eB;
-				else if(decl.parent == eB) decl.parent = eA;
-			}
+			bool operator==(const FunctionDeclaire& o) const { return parent == o.parent && symbol == o.symbol; }
+			static constexpr ecs::entity_fields entity_references{&FunctionDeclaire::parent};
 		};
 		struct BodyMarker {
 			doir::Token skipTo;
-			static void swap_entities(BodyMarker& mark, ecs::entity eA, ecs::entity eB) {
-				if(mark.skipTo == eA) mark.skipTo = eB;
-				else if(mark.skipTo == eB) mark.skipTo = eA;
-			}
+			static constexpr ecs::entity_fields entity_references{&BodyMarker::skipTo};
 		};
 		struct ParameterDeclaire {
 			doir::Lexeme name;
+			doir::SymbolId symbol;
 			doir::Token parent; // Parent function
-			bool operator==(const ParameterDeclaire& o) const {
-				return parent == o.parent && name.view(doir::hash_lookup_module->buffer)
-					== o.name.view(doir::hash_lookup_module->buffer);
-			}
-			static void swap_entities(ParameterDeclaire& decl, ecs::entity eA, ecs::entity eB) {
-				if(decl.parent == eA) decl.parent = eB;
-				else if(decl.parent == eB) decl.parent = eA;
-			}
+			bool operator==(const ParameterDeclaire& o) const { return parent == o.parent && symbol == o.symbol; }
+			static constexpr ecs::entity_fields entity_references{&ParameterDeclaire::parent};
 		};
 		struct Parameters : public std::vector<doir::Token> {
 			using std::vector<doir::Token>::vector;
-			static void swap_entities(Parameters& params, ecs::entity eA, ecs::entity eB) {
-				for(auto& param: params)
-					if(param == eA) param = eB;
-					else if(param == eB) param = eA;
-			}
+			static constexpr ecs::entity_fields entity_references{ecs::self_elements};
 		};
 
 		struct Operation {
 			doir::Token left = 0, right = 0;
-			static void swap_entities(Operation& op, ecs::entity eA, ecs::entity eB) {
-				if(op.left == eA) op.left = eB;
-				else if(op.left == eB) op.left = eA;
-
-				if(op.right == eA) op.right = eB;
-				else if(op.right == eB) op.right = eA;
-			}
+			static constexpr ecs::entity_fields entity_references{&Operation::left, &Operation::right};
 		};
 		struct OperationIf : public std::array<doir::Token, 4> { // Condition, Then, Else, Marker
-			static void swap_entities(OperationIf& op, ecs::entity eA, ecs::entity eB) {
-				for(auto& child: op)
-					if(child == eA) child = eB;
-					else if(child == eB) child = eA;
-			}
+			static constexpr ecs::entity_fields entity_references{ecs::self_elements};
 		};
 
 		struct Not {};
@@ -209,6 +170,14 @@ namespace lox {
 		struct Return {};
 		struct While {};
 		struct If {};
+
+		// Indexes declarations by the block they live in and their name, so a block's declarations form one contiguous (sorted) run
+		template<typename Tdeclaration>
+		struct DeclaredIn {
+			std::pair<doir::Token, doir::SymbolId> operator()(const Tdeclaration& declaration) const { return {declaration.parent, declaration.symbol}; }
+		};
+		template<typename Tdeclaration>
+		using DeclarationIndex = doir::Index<Tdeclaration, DeclaredIn<Tdeclaration>>;
 	}
 	namespace comp = components;
 
@@ -258,6 +227,11 @@ namespace lox {
 			return module.add_attribute<comp::Block>(currentBlock) = {.parent = parent};
 		}
 
+		// Identifiers are interned as soon as their token is made, so later passes compare (and hash) names as integers
+		doir::SymbolId intern_identifier(doir::ParseModule& module, doir::Token t) {
+			return module.add_attribute<doir::SymbolId>(t) = module.intern(module.get_attribute<doir::Lexeme>(t)->view(module.buffer));
+		}
+
 		void declaire_builtin_functions(doir::ParseModule& module) {
 			auto& block = *module.get_attribute<components::Block>(currentBlock);
 			module.buffer += "\n"; // Make sure our scratch space doesn't show up in any diagnostics
@@ -268,7 +242,8 @@ namespace lox {
 				*module.get_attribute<doir::Lexeme>(clock) = {module.buffer.size(), str.size()};
 				module.buffer += str;
 			}
-			module.add_hashtable_attribute<components::FunctionDeclaire>(clock) = {*module.get_attribute<doir::Lexeme>(clock), currentBlock};
+			auto symbol = intern_identifier(module, clock); // Interned first, since it adds an attribute (which can move the token's others)
+			module.add_attribute<components::FunctionDeclaire>(clock) = {*module.get_attribute<doir::Lexeme>(clock), symbol, currentBlock};
 			module.add_attribute<comp::Parameters>(clock) = {};
 			module.add_attribute<comp::Operation>(clock) = {doir::InvalidToken, false}; // .right stores weather or not the function is currently being called
 			block.children.emplace_back(clock);
@@ -277,7 +252,10 @@ namespace lox {
 		// program ::= declaration* EOF;
 		doir::Token start(doir::ParseModule& module) {
 			ZoneScoped;
-			if(module.lexer_state.lexeme.empty()) module.lex(lexer);
+			if(module.lexer_state.lexeme.empty()) {
+				module.reserve_for_tokens();
+				module.lex(lexer);
+			}
 
 			// comp::Block& topBlock = make_block(module);
 			make_block(module);
@@ -344,6 +322,7 @@ namespace lox {
 			ZoneScoped;
 			auto t = module.make_token();
 			PROPAGATE_OPTIONAL_ERROR(module.expect_and_lex(lexer, LexerTokens::Identifier));
+			auto symbol = intern_identifier(module, t);
 			PROPAGATE_OPTIONAL_ERROR(module.expect_and_lex(lexer, LexerTokens::OpenParenthesis));
 
 			comp::Parameters params;
@@ -357,7 +336,7 @@ namespace lox {
 			PROPAGATE_OPTIONAL_ERROR(module.expect_and_lex(lexer, LexerTokens::CloseParenthesis));
 			auto body = block(module, t); PROPAGATE_ERROR(body);
 
-			module.add_hashtable_attribute<comp::FunctionDeclaire>(t) = {*module.get_attribute<doir::Lexeme>(t), currentBlock};
+			module.add_attribute<comp::FunctionDeclaire>(t) = {*module.get_attribute<doir::Lexeme>(t), symbol, currentBlock};
 			module.add_attribute<comp::Parameters>(t) = params;
 			module.add_attribute<comp::Operation>(t) = {body, false}; // .right stores weather or not the function is currently being called
 			return t;
@@ -372,7 +351,8 @@ namespace lox {
 				if(auto e = module.expect_and_lex(lexer, LexerTokens::Identifier); e) return {*e};
 
 				params.emplace_back(t);
-				module.add_hashtable_attribute<comp::ParameterDeclaire>(t) = {*module.get_attribute<doir::Lexeme>(t), function};
+				auto symbol = intern_identifier(module, t); // Interned first, since it adds an attribute (which can move the token's others)
+				module.add_attribute<comp::ParameterDeclaire>(t) = {*module.get_attribute<doir::Lexeme>(t), symbol, function};
 
 				if(module.current_lexer_token<LexerTokens>() != Comma) break;
 				module.lex(lexer);
@@ -409,6 +389,7 @@ namespace lox {
 			PROPAGATE_OPTIONAL_ERROR(module.expect(LexerTokens::Identifier));
 
 			auto t = module.make_token();
+			auto symbol = intern_identifier(module, t);
 
 			doir::Token defaultValue = 0;
 			auto next = module.lookahead(lexer);
@@ -422,7 +403,7 @@ namespace lox {
 			module.lex(lexer);
 			PROPAGATE_OPTIONAL_ERROR(module.expect(LexerTokens::Semicolon));
 
-			module.add_hashtable_attribute<comp::VariableDeclaire>(t) = {*module.get_attribute<doir::Lexeme>(t), currentBlock};
+			module.add_attribute<comp::VariableDeclaire>(t) = {*module.get_attribute<doir::Lexeme>(t), symbol, currentBlock};
 			if(defaultValue != 0)
 				module.add_attribute<comp::Operation>(t) = {defaultValue};
 			return t;
@@ -455,8 +436,8 @@ namespace lox {
 		// forStmt ::= "for" "(" ( varDecl | exprStmt | ";" ) expression? ";" expression? ")" statement;
 		doir::Token forStmt(doir::ParseModule& module) {
 			ZoneScoped;
-			auto t = module.make_token();
-			auto marker = module.make_token();
+			auto t = module.make_tokens(2); // The statement and its marker
+			doir::Token marker = t + 1;
 			PROPAGATE_OPTIONAL_ERROR(module.expect_and_lex(lexer, LexerTokens::For));
 			PROPAGATE_OPTIONAL_ERROR(module.expect_and_lex(lexer, LexerTokens::OpenParenthesis));
 
@@ -496,7 +477,7 @@ namespace lox {
 
 			// Make a while loop with the condition
 			module.add_attribute<comp::While>(t);
-			auto& loc = *module.get_attribute<doir::NamedSourceLocation>(t);
+			auto loc = *module.get_attribute<doir::NamedSourceLocation>(t);
 			auto& operation = module.add_attribute<comp::Operation>(t) = {.right = stmt};
 			if(condition != 0)
 				operation.left = condition;
@@ -538,8 +519,8 @@ namespace lox {
 		// ifStmt ::= "if" "(" expression ")" statement ( "else" statement )?;
 		doir::Token ifStmt(doir::ParseModule& module) {
 			ZoneScoped;
-			auto t = module.make_token();
-			auto marker = module.make_token();
+			auto t = module.make_tokens(2); // The statement and its marker
+			doir::Token marker = t + 1;
 			PROPAGATE_OPTIONAL_ERROR(module.expect_and_lex(lexer, LexerTokens::If));
 			PROPAGATE_OPTIONAL_ERROR(module.expect_and_lex(lexer, LexerTokens::OpenParenthesis));
 
@@ -599,8 +580,8 @@ namespace lox {
 		// whileStmt ::= "while" "(" expression ")" statement;
 		doir::Token whileStmt(doir::ParseModule& module) {
 			ZoneScoped;
-			auto t = module.make_token();
-			auto marker = module.make_token();
+			auto t = module.make_tokens(2); // The statement and its marker
+			doir::Token marker = t + 1;
 			PROPAGATE_OPTIONAL_ERROR(module.expect_and_lex(lexer, LexerTokens::While));
 			PROPAGATE_OPTIONAL_ERROR(module.expect_and_lex(lexer, LexerTokens::OpenParenthesis));
 
@@ -682,6 +663,7 @@ namespace lox {
 				// TODO: If var is set need to do something to handle the class!
 				if(parent) return module.make_error<doir::Error>({"Classes are not yet supported!"});
 				auto name = *module.get_attribute<doir::Lexeme>(t);
+				intern_identifier(module, t);
 
 				module.lex(lexer);
 				PROPAGATE_OPTIONAL_ERROR(module.expect_and_lex(lexer, LexerTokens::Assign));
@@ -716,8 +698,8 @@ namespace lox {
 			) {
 				module.restore_state(peak);
 
-				auto t = module.make_token();
-				auto marker = module.make_token();
+				auto t = module.make_tokens(2); // The statement and its marker
+				doir::Token marker = t + 1;
 
 				module.lex(lexer);
 				doir::Token b = logic_and(module); PROPAGATE_ERROR(b);
@@ -741,8 +723,8 @@ namespace lox {
 			) {
 				module.restore_state(peak);
 
-				auto t = module.make_token();
-				auto marker = module.make_token();
+				auto t = module.make_tokens(2); // The statement and its marker
+				doir::Token marker = t + 1;
 
 				module.lex(lexer);
 				doir::Token b = equality(module); PROPAGATE_ERROR(b);
@@ -973,12 +955,12 @@ namespace lox {
 				// Ensure the existence of the trailing quote
 				if(std::ranges::count(lexem.view(module.buffer), '"') < 2)
 					return module.make_error<doir::Error>({"Expected a terminating `\"`!"});
-				module.add_attribute<comp::Literal>(t);
-				module.add_attribute<comp::String>(t);
 
-				// Remove the quotes from the token
+				// Remove the quotes from the token (before adding attributes, which may relocate the lexeme)
 				++lexem.start;
 				lexem.length -= 2; // -1 just compensates for the start being pushed back one
+				module.add_attribute<comp::Literal>(t);
+				module.add_attribute<comp::String>(t);
 				return t;
 			}
 			case LexerTokens::Number: {
@@ -992,6 +974,7 @@ namespace lox {
 				auto t = module.make_token();
 				module.add_attribute<comp::Variable>(t);
 				module.add_attribute<doir::TokenReference>(t) = *module.get_attribute<doir::Lexeme>(t);
+				intern_identifier(module, t);
 				return t;
 			}
 			// case LexerTokens::Super: {
@@ -1010,26 +993,18 @@ namespace lox {
 	};
 }
 
-namespace fnv {
+namespace wyhash {
 	template<>
-	struct fnv1a_64<lox::comp::VariableDeclaire> {
-		inline uint64_t operator()(const lox::comp::VariableDeclaire& v) {
-			return fnv1a_64<std::string_view>{}(v.name.view(doir::hash_lookup_module->buffer))
-				^ fnv1a_64<doir::Token>{}(v.parent);
-		}
+	struct wyhash_64<lox::comp::VariableDeclaire> {
+		constexpr uint64_t operator()(const lox::comp::VariableDeclaire& v) const { return hash_integer(uint64_t(v.symbol), v.parent); } // Names are interned, so no string needs to be hashed
 	};
 	template<>
-	struct fnv1a_64<lox::comp::FunctionDeclaire> {
-		inline uint64_t operator()(const lox::comp::FunctionDeclaire& f) {
-			return fnv1a_64<std::string_view>{}(f.name.view(doir::hash_lookup_module->buffer))
-				^ fnv1a_64<doir::Token>{}(f.parent);
-		}
+	struct wyhash_64<lox::comp::FunctionDeclaire> {
+		constexpr uint64_t operator()(const lox::comp::FunctionDeclaire& f) const { return hash_integer(uint64_t(f.symbol), f.parent); }
 	};
 	template<>
-	struct fnv1a_64<lox::comp::ParameterDeclaire> {
-		inline uint64_t operator()(const lox::comp::ParameterDeclaire& p) {
-			return fnv1a_64<std::string_view>{}(p.name.view(doir::hash_lookup_module->buffer))
-				^ fnv1a_64<doir::Token>{}(p.parent);
-		}
+	struct wyhash_64<lox::comp::ParameterDeclaire> {
+		constexpr uint64_t operator()(const lox::comp::ParameterDeclaire& p) const { return hash_integer(uint64_t(p.symbol), p.parent); }
 	};
 }
+
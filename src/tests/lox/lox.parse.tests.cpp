@@ -1,4 +1,6 @@
 #include "lox.parse.hpp"
+#include <chrono>
+#include <random>
 
 TEST_CASE("Lox::Nil") {
 	ZoneScopedN("Lox::Nil");
@@ -477,11 +479,46 @@ TEST_CASE("Lox::Var") {
 	doir::ParseModule module("var x;");
 	lox::parse p;
 	auto root = module.get_attribute<lox::components::Block>(p.start(module))->children[0];
-	CHECK(get_key<lox::components::VariableDeclaire>(module.get_hashtable_attribute<lox::components::VariableDeclaire>(root)).name.view(module.buffer) == "x");
+	CHECK(module.get_attribute<lox::components::VariableDeclaire>(root)->name.view(module.buffer) == "x");
 	CHECK(module.has_attribute<lox::components::Operation>(root) == false);
 
+	CHECK(*module.get_index<lox::components::DeclarationIndex<lox::components::VariableDeclaire>>().find_first({1, *module.symbols.find("x")}) == root);
+	FrameMark;
+}
+
+// The parser stores declarations as plain attributes (sema finds them through a DeclarationIndex), so the hashtable tests copy them into a hashtable first
+template<typename Tdeclaration>
+static void hash_declarations(doir::Module& module) {
+	for(doir::Token t = 0; t < module.token_count(); ++t)
+		if(module.has_attribute<Tdeclaration>(t)) {
+			Tdeclaration declaration = *module.get_attribute<Tdeclaration>(t); // Copied since adding an attribute may move the token's others
+			module.add_hashtable_attribute<Tdeclaration>(t) = declaration;
+		}
+}
+
+TEST_CASE("Lox::VarInsertRemove") {
+	ZoneScopedN("Lox::VarInsertRemove");
+	doir::ParseModule module("var x; var y;");
+	lox::parse p;
+	auto& children = module.get_attribute<lox::components::Block>(p.start(module))->children;
+	hash_declarations<lox::components::VariableDeclaire>(module);
+	auto x = children[0], y = children[1];
+	auto key = get_key<lox::components::VariableDeclaire>(module.get_hashtable_attribute<lox::components::VariableDeclaire>(x));
+
+	// Removing a declaration edits the table in place
+	CHECK(module.remove_hashtable_attribute<lox::components::VariableDeclaire>(x));
+	CHECK(!module.has_hashtable_attribute<lox::components::VariableDeclaire>(x));
 	auto& hashtable = *module.get_hashtable<lox::components::VariableDeclaire>();
-	CHECK(*hashtable.find({{module.buffer.find("x"), 1}, 1}) == root);
+	CHECK(!hashtable.find(key, module));
+	CHECK(*hashtable.find({{module.buffer.find("y"), 1}, *module.symbols.find("y"), 1}, module) == y);
+
+	// And so does inserting one (duplicates are rejected)
+	auto z = module.make_token();
+	CHECK(module.insert_hashtable_attribute<lox::components::VariableDeclaire>(z, key));
+	CHECK(!module.insert_hashtable_attribute<lox::components::VariableDeclaire>(x, key));
+	CHECK(module.has_hashtable_attribute<lox::components::VariableDeclaire>(z));
+	CHECK(*hashtable.find(key, module) == z);
+	CHECK(*hashtable.find({{module.buffer.find("y"), 1}, *module.symbols.find("y"), 1}, module) == y);
 	FrameMark;
 }
 
@@ -490,12 +527,11 @@ TEST_CASE("Lox::VarDefault") {
 	doir::ParseModule module("var x = 5;");
 	lox::parse p;
 	auto root = module.get_attribute<lox::components::Block>(p.start(module))->children[0];
-	CHECK(get_key<lox::components::VariableDeclaire>(module.get_hashtable_attribute<lox::components::VariableDeclaire>(root)).name.view(module.buffer) == "x");
+	CHECK(module.get_attribute<lox::components::VariableDeclaire>(root)->name.view(module.buffer) == "x");
 	auto target = module.get_attribute<lox::components::Operation>(root)->left;
 	CHECK(*module.get_attribute<double>(target) == 5);
 
-	auto& hashtable = *module.get_hashtable<lox::components::VariableDeclaire>();
-	CHECK(*hashtable.find({{module.buffer.find("x"), 1}, 1}) == root);
+	CHECK(*module.get_index<lox::components::DeclarationIndex<lox::components::VariableDeclaire>>().find_first({1, *module.symbols.find("x")}) == root);
 	FrameMark;
 }
 
@@ -504,13 +540,13 @@ TEST_CASE("Lox::Fun") {
 	doir::ParseModule module("fun f(x, y) { return x; }");
 	lox::parse p;
 	auto root = module.get_attribute<lox::components::Block>(p.start(module))->children[0];
-	CHECK(get_key<lox::components::FunctionDeclaire>(module.get_hashtable_attribute<lox::components::FunctionDeclaire>(root)).name.view(module.buffer) == "f");
+	CHECK(module.get_attribute<lox::components::FunctionDeclaire>(root)->name.view(module.buffer) == "f");
 	{
 		auto& params = *module.get_attribute<lox::components::Parameters>(root);
 		CHECK(params.size() == 2);
-		CHECK(module.has_hashtable_attribute<lox::components::ParameterDeclaire>(params[0]));
+		CHECK(module.has_attribute<lox::components::ParameterDeclaire>(params[0]));
 		CHECK(module.get_attribute<doir::Lexeme>(params[0])->view(module.buffer) == "x");
-		CHECK(module.has_hashtable_attribute<lox::components::ParameterDeclaire>(params[1]));
+		CHECK(module.has_attribute<lox::components::ParameterDeclaire>(params[1]));
 		CHECK(module.get_attribute<doir::Lexeme>(params[1])->view(module.buffer) == "y");
 	}
 	{
@@ -525,8 +561,7 @@ TEST_CASE("Lox::Fun") {
 		CHECK(module.get_attribute<doir::TokenReference>(target)->lexeme().view(module.buffer) == "x");
 	}
 
-	auto& hashtable = *module.get_hashtable<lox::components::FunctionDeclaire>();
-	CHECK(*hashtable.find({{module.buffer.find("f"), 1}, 1}) == root);
+	CHECK(*module.get_index<lox::components::DeclarationIndex<lox::components::FunctionDeclaire>>().find_first({1, *module.symbols.find("f")}) == root);
 	FrameMark;
 }
 
@@ -564,4 +599,113 @@ TEST_CASE("Lox::Parse") {
 		CHECK(module.get_attribute<doir::TokenReference>(call.children[0])->lexeme().view(module.buffer) == "x");
 	}
 	FrameMark;
-}
\ No newline at end of file
+}
+
+// Declares count variables spread across nested blocks, so lookups see a realistic mix of names and parents
+static std::string many_variables(size_t count) {
+	std::string source;
+	for(size_t i = 0; i < count; ++i) {
+		if(i % 16 == 0) source += "{ ";
+		source += "var v" + std::to_string(i) + " = " + std::to_string(i) + "; ";
+		if(i % 16 == 15) source += "} ";
+	}
+	if(count % 16) source += "}";
+	return source;
+}
+
+TEST_CASE("Lox::Symbols") {
+	ZoneScopedN("Lox::Symbols");
+	doir::ParseModule module("var x = 1; fun f(a, x) { print a + x; } x = f(x, 2);");
+	auto root = lox::parse{}.start(module);
+	REQUIRE(root != 0);
+
+	// Every occurrence of a name shares one dense symbol
+	auto x = *module.symbols.find("x");
+	for(doir::Token t = 0; t < module.token_count(); ++t)
+		if(auto symbol = module.get_attribute<doir::SymbolId>(t); symbol)
+			CHECK(module.symbol_name(*symbol) == module.get_attribute<doir::Lexeme>(t)->view(module.buffer));
+	auto& children = module.get_attribute<lox::components::Block>(root)->children;
+	CHECK(module.get_attribute<lox::components::VariableDeclaire>(children[0])->symbol == x);
+	auto& params = *module.get_attribute<lox::components::Parameters>(children[1]);
+	CHECK(module.get_attribute<lox::components::ParameterDeclaire>(params[1])->symbol == x);
+	CHECK(*module.get_attribute<doir::SymbolId>(children[2]) == x); // The assignment's target
+	CHECK(module.symbols.size() == 4); // clock, x, f, a
+	CHECK(module.intern("f") == *module.symbols.find("f"));
+	CHECK(!module.symbols.find("print"));
+	CHECK(module.symbols.contains(doir::SymbolId(3)));
+	CHECK(!module.symbols.contains(doir::InvalidSymbol));
+
+	// Copies intern into their own storage
+	doir::Interner copy = module.symbols;
+	CHECK(copy.name(x) == "x");
+	CHECK(copy.name(x).data() != module.symbol_name(x).data());
+	CHECK(copy.intern("new") == doir::SymbolId(4));
+	CHECK(module.symbols.size() == 4);
+	FrameMark;
+}
+
+TEST_CASE("Lox::SwissHashtable") {
+	ZoneScopedN("Lox::SwissHashtable");
+	doir::ParseModule hopscotch(many_variables(100)), swiss(many_variables(100));
+	REQUIRE(lox::parse{}.start(hopscotch) != 0);
+	REQUIRE(lox::parse{}.start(swiss) != 0);
+	hash_declarations<lox::components::VariableDeclaire>(hopscotch);
+	hash_declarations<lox::components::VariableDeclaire>(swiss);
+	auto& hopscotchTable = *hopscotch.get_hashtable<lox::components::VariableDeclaire>();
+	auto& swissTable = *swiss.get_swiss_hashtable<lox::components::VariableDeclaire>();
+	CHECK(swissTable.occupied() == 100);
+
+	// Both tables find the same declaration for every key (the modules parsed the same source, so they interned the same symbols)
+	for(auto& cell: hopscotch.get_hashtable_attribute_as_span<lox::components::VariableDeclaire>())
+		if(cell->is_occupied()) {
+			CHECK(*hopscotchTable.find(cell->key, hopscotch) == cell.entity);
+			CHECK(*swissTable.find(cell->key, swiss) == cell.entity);
+		}
+	CHECK(!swissTable.find({{0, 1}, swiss.intern("{"), 1}, swiss)); // "{" was never declared
+	FrameMark;
+}
+
+TEST_CASE("Lox::Benchmark::hashtable" * doctest::skip()) {
+	ZoneScopedN("Lox::Benchmark::hashtable");
+	constexpr size_t count = 100'000, iterations = 20;
+	doir::ParseModule hopscotch(many_variables(count)), swiss(many_variables(count));
+	REQUIRE(lox::parse{}.start(hopscotch) != 0);
+	REQUIRE(lox::parse{}.start(swiss) != 0);
+	hash_declarations<lox::components::VariableDeclaire>(hopscotch);
+	hash_declarations<lox::components::VariableDeclaire>(swiss);
+	auto& hopscotchTable = *hopscotch.get_hashtable<lox::components::VariableDeclaire>();
+	auto& swissTable = *swiss.get_swiss_hashtable<lox::components::VariableDeclaire>();
+
+	std::vector<lox::components::VariableDeclaire> keys;
+	for(auto& cell: hopscotch.get_hashtable_attribute_as_span<lox::components::VariableDeclaire>())
+		if(cell->is_occupied()) keys.push_back(cell->key);
+	std::shuffle(keys.begin(), keys.end(), std::mt19937{42}); // Don't let either table walk its cells in order
+	std::vector<lox::components::VariableDeclaire> missing = keys;
+	for(auto& key: missing) key.parent += 1; // Same names in the wrong block
+
+	auto time = [&](auto& table, const doir::Module& module, const std::vector<lox::components::VariableDeclaire>& keys, size_t& found) {
+		auto start = std::chrono::steady_clock::now();
+		for(size_t i = 0; i < iterations; ++i)
+			for(auto& key: keys)
+				found += table.find(key, module).has_value();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+	size_t hopscotchFound = 0, swissFound = 0, hopscotchMissed = 0, swissMissed = 0;
+	double hopscotchMs, swissMs, hopscotchMissMs, swissMissMs;
+	{
+		ZoneScopedN("Lox::Benchmark::hashtable::hopscotch");
+		hopscotchMs = time(hopscotchTable, hopscotch, keys, hopscotchFound);
+		hopscotchMissMs = time(hopscotchTable, hopscotch, missing, hopscotchMissed);
+	}
+	{
+		ZoneScopedN("Lox::Benchmark::hashtable::swiss");
+		swissMs = time(swissTable, swiss, keys, swissFound);
+		swissMissMs = time(swissTable, swiss, missing, swissMissed);
+	}
+	CHECK(swissFound == keys.size() * iterations);
+	CHECK(hopscotchFound == keys.size() * iterations);
+	CHECK(swissMissed == 0);
+	CHECK(hopscotchMissed == 0);
+	MESSAGE("VariableDeclaire lookups: hopscotch " << hopscotchMs << "ms (" << hopscotchMissMs << "ms missing), swiss " << swissMs << "ms (" << swissMissMs << "ms missing)");
+	FrameMark;
+}
@@ -1,7 +1,9 @@
 #include "lox.hpp"
 #include "lox.parse.hpp"
 #include <algorithm>
+#include <chrono>
 #include <iterator>
+#include <numeric>
 #include <ranges>
 #include <sstream>
 #include <unordered_set>
@@ -104,24 +106,15 @@ void sort_parse_into_reverse_post_order_traversal(doir::Module& module, doir::To
 	}
 	{
 		ZoneScopedN("sort_parse_into_reverse_post_order_traversal::reorder");
-		((ecs::scene*)&module)->reorder_entities<
-			doir::hashtable_t<lox::comp::VariableDeclaire>,
-			doir::hashtable_t<lox::comp::FunctionDeclaire>,
-			lox::comp::BodyMarker,
-			lox::comp::Operation,
-			lox::comp::OperationIf,
-			lox::comp::Block,
-			lox::comp::Parameters
-		>(order);
+		((ecs::scene*)&module)->reorder_entities(order); // Every component storing tokens registers them, so they are remapped automatically
 	}
-	// TODO: There is a bug in make_monotonic!
-	// module.make_monotonic<
-	// 	lox::comp::BodyMarker,
-	// 	lox::comp::Operation,
-	// 	lox::comp::OperationIf,
-	// 	lox::comp::Block,
-	// 	lox::comp::Parameters
-	// >();
+	module.make_monotonic<
+		lox::comp::BodyMarker,
+		lox::comp::Operation,
+		lox::comp::OperationIf,
+		lox::comp::Block,
+		lox::comp::Parameters
+	>();
 };
 
 size_t calculate_child_count(doir::Module& module, doir::Token root = 1, bool annotate = true) {
@@ -225,22 +218,21 @@ doir::Token current_function(doir::Module& module, doir::Token root) {
 	doir::Token target = root;
 	do {
 		--root;
-		for(; !module.has_hashtable_attribute<lox::comp::FunctionDeclaire>(root) && root > 0; --root);
+		for(; !module.has_attribute<lox::comp::FunctionDeclaire>(root) && root > 0; --root);
 	} while(root > 0 && root + module.get_attribute<doir::Children>(root)->total < target); // If our offset is larger than the number of children in the block... we can't be its child
 	return root;
 }
 
+// NOTE: Takes the index rather than asking the module for it, so that lookups from several threads don't race to bring it up to date
 template<typename Tkey>
-std::optional<doir::Token> blockwise_find(doir::Module& module, Tkey key, bool has) {
+std::optional<doir::Token> blockwise_find(doir::Module& module, const lox::comp::DeclarationIndex<Tkey>& declarations, Tkey key) {
 	ZoneScoped;
-	auto& hashtable = module.get_hashtable<Tkey>(true).value();
 	while(key.parent > 0) {
-		auto dbg = key.name.view(module.buffer);
-		if(has) if(auto res = hashtable.find(key); res) return *res;
+		if(auto res = declarations.find_first({key.parent, key.symbol}); res) return *res;
 
 		if(auto f = current_function(module, key.parent); f) {
 			for(auto& param: *module.get_attribute<lox::comp::Parameters>(f))
-				if(module.get_attribute<doir::Lexeme>(param)->view(module.buffer) == key.name.view(module.buffer))
+				if(*module.get_attribute<doir::SymbolId>(param) == key.symbol)
 					return param;
 		}
 		key.parent = current_block(module, key.parent);
@@ -248,55 +240,57 @@ std::optional<doir::Token> blockwise_find(doir::Module& module, Tkey key, bool h
 	return {};
 }
 
+// Every token's lookup only reads the tree and writes its own reference (calls write their target's, which no other call shares),
+//	so each pass is split across threads. Calls are resolved before variables since a call target which isn't a function is looked up as a variable
 void lookup_references(doir::Module& module, bool clear_references = true) {
 	ZoneScoped;
-	// We don't ever use these hashtable references... they are just here to make sure the tables are built for blockwise_find
-	auto& functions = *module.get_hashtable<lox::comp::FunctionDeclaire>();
-	bool hasFunctions = functions.size();
-	auto& variables = *module.get_hashtable<lox::comp::VariableDeclaire>();
-	bool hasVariables = variables.size();
+	// Brought up to date once, before any threads read them (Only updated if declarations were added or moved since the last lookup)
+	auto& functions = module.get_index<lox::comp::DeclarationIndex<lox::comp::FunctionDeclaire>>();
+	auto& variables = module.get_index<lox::comp::DeclarationIndex<lox::comp::VariableDeclaire>>();
 
-	if(!hasFunctions && !hasVariables) return;
+	if(functions.empty() && variables.empty()) return;
 
-	if(clear_references) for(doir::Token t = module.get_attribute<doir::Children>(1)->total + 2; t--;) {
-		if(!module.has_attribute<doir::TokenReference>(t)) continue;
-		*module.get_attribute<doir::TokenReference>(t) = *module.get_attribute<doir::Lexeme>(t);
-	}
+	doir::Token end = module.get_attribute<doir::Children>(1)->total + 2;
+	if(clear_references) doir::par_for_each<doir::include_token, doir::TokenReference>(module, [&](auto tuple) {
+		auto [t, ref] = tuple;
+		if(t < end) ref = *module.get_attribute<doir::Lexeme>(t);
+	});
 
-	for(doir::Token t = module.get_attribute<doir::Children>(1)->total + 2; t--;) {
-		if(!module.has_attribute<doir::TokenReference>(t) && !module.has_attribute<lox::comp::Function>(t)) continue;
-
-		if(module.has_attribute<lox::comp::Function>(t)) {
-			auto& call = *module.get_attribute<lox::comp::Call>(t);
-			auto& ref = *module.get_attribute<doir::TokenReference>(call.parent);
-			if(ref.looked_up()) continue;
-
-			auto block = current_block(module, t);
-			auto res = blockwise_find<lox::comp::FunctionDeclaire>(module, {ref.lexeme(), block}, hasFunctions);
-			while(res && *res < t) { // Function declaired after... so we need to search in a higher block!
-				if(*res + module.get_attribute<doir::Children>(*res)->total > t) break; // Recursive calls will fail previous check!
-				if(*res <= 2) break; // Builtin functions will fail previous check!
-				block = current_block(module, block);
-				res = blockwise_find<lox::comp::FunctionDeclaire>(module, {ref.lexeme(), block}, hasFunctions);
-			}
-			if(res) ref = *res;
+	doir::par_for_each<doir::include_token, lox::comp::Call>(module, [&](auto tuple) {
+		auto [t, call] = tuple;
+		if(t >= end || !module.has_attribute<lox::comp::Function>(t)) return;
+		auto& ref = *module.get_attribute<doir::TokenReference>(call.parent);
+		if(ref.looked_up()) return;
+		auto symbol = *module.get_attribute<doir::SymbolId>(call.parent);
+
+		auto block = current_block(module, t);
+		auto res = blockwise_find<lox::comp::FunctionDeclaire>(module, functions, {ref.lexeme(), symbol, block});
+		while(res && *res < t) { // Function declaired after... so we need to search in a higher block!
+			if(*res + module.get_attribute<doir::Children>(*res)->total > t) break; // Recursive calls will fail previous check!
+			if(*res <= 2) break; // Builtin functions will fail previous check!
+			block = current_block(module, block);
+			res = blockwise_find<lox::comp::FunctionDeclaire>(module, functions, {ref.lexeme(), symbol, block});
 		}
-		if((module.has_attribute<lox::comp::Variable>(t) || module.has_attribute<lox::comp::Assign>(t))) {
-			auto& ref = *module.get_attribute<doir::TokenReference>(t);
-			if(ref.looked_up()) continue;
-			if(module.has_attribute<lox::comp::Function>(t - 1)) continue;
-
-			auto block = current_block(module, t);
-			auto res = blockwise_find<lox::comp::VariableDeclaire>(module, {ref.lexeme(), block}, hasVariables);
-			while(res && *res < t) { // Variable declaired after... so we need to search in a higher block!
-				if(module.has_hashtable_attribute<lox::components::ParameterDeclaire>(*res)) break; // Parameters will fail the previous check!
-				if(module.has_attribute<lox::components::Call>(t - 1)) break; // Call targets will also fail!
-				block = current_block(module, block);
-				res = blockwise_find<lox::comp::VariableDeclaire>(module, {ref.lexeme(), block}, hasVariables);
-			}
-			if(res) ref = *res;
+		if(res) ref = *res;
+	});
+
+	doir::par_for_each<doir::include_token, doir::TokenReference>(module, [&](auto tuple) {
+		auto [t, ref] = tuple;
+		if(t >= end || ref.looked_up()) return;
+		if(!module.has_attribute<lox::comp::Variable>(t) && !module.has_attribute<lox::comp::Assign>(t)) return;
+		if(t > 0 && module.has_attribute<lox::comp::Function>(t - 1)) return;
+		auto symbol = *module.get_attribute<doir::SymbolId>(t);
+
+		auto block = current_block(module, t);
+		auto res = blockwise_find<lox::comp::VariableDeclaire>(module, variables, {ref.lexeme(), symbol, block});
+		while(res && *res < t) { // Variable declaired after... so we need to search in a higher block!
+			if(module.has_attribute<lox::components::ParameterDeclaire>(*res)) break; // Parameters will fail the previous check!
+			if(module.has_attribute<lox::components::Call>(t - 1)) break; // Call targets will also fail!
+			block = current_block(module, block);
+			res = blockwise_find<lox::comp::VariableDeclaire>(module, variables, {ref.lexeme(), symbol, block});
 		}
-	}
+		if(res) ref = *res;
+	});
 }
 
 bool verify_references(doir::Module& module) {
@@ -323,38 +317,45 @@ bool verify_references(doir::Module& module) {
 	return valid;
 }
 
+// Orders two declarations of the same name as (redeclaration, original) by their position in the source
+//	(canonicalizing can renumber declarations, so the index's token order doesn't always match the source)
+std::pair<doir::Token, doir::Token> order_declarations(doir::Module& module, doir::Token a, doir::Token b) {
+	if(module.get_attribute<doir::Lexeme>(a)->start < module.get_attribute<doir::Lexeme>(b)->start) return {b, a};
+	return {a, b};
+}
+
 bool verify_redeclarations(doir::Module& module) {
 	ZoneScoped;
-	auto& functions = *module.get_hashtable<lox::comp::FunctionDeclaire>();
-	bool hasFunctions = functions.size();
-	auto& variables = *module.get_hashtable<lox::comp::VariableDeclaire>();
-	bool hasVariables = variables.size();
+	auto& functions = module.get_index<lox::comp::DeclarationIndex<lox::comp::FunctionDeclaire>>();
+	auto& variables = module.get_index<lox::comp::DeclarationIndex<lox::comp::VariableDeclaire>>();
 
-	if(!hasFunctions && !hasVariables) return true;
+	if(functions.empty() && variables.empty()) return true;
 
 	bool valid = true;
 	for(doir::Token t = module.get_attribute<doir::Children>(1)->total + 2; t--;) {
 		if(
-			!module.has_hashtable_attribute<lox::components::VariableDeclaire>(t) 
-			&& !module.has_hashtable_attribute<lox::components::FunctionDeclaire>(t)
-			&& !module.has_hashtable_attribute<lox::components::ParameterDeclaire>(t)
+			!module.has_attribute<lox::components::VariableDeclaire>(t) 
+			&& !module.has_attribute<lox::components::FunctionDeclaire>(t)
+			&& !module.has_attribute<lox::components::ParameterDeclaire>(t)
 		) continue;
 
-		if(module.has_hashtable_attribute<lox::components::FunctionDeclaire>(t)) {
+		if(module.has_attribute<lox::components::FunctionDeclaire>(t)) {
 			auto& lexeme = *module.get_attribute<doir::Lexeme>(t);
-			auto res = *blockwise_find<lox::comp::FunctionDeclaire>(module, {lexeme, current_block(module, t)}, hasFunctions);
+			auto res = *blockwise_find<lox::comp::FunctionDeclaire>(module, functions, {lexeme, *module.get_attribute<doir::SymbolId>(t), current_block(module, t)});
 			if(res != t) {
-				doir::print_diagnostic(module, res, (std::stringstream{} << "Function " << lexeme.view(module.buffer) << " redeclaired!").str()) << "\n";
-				doir::print_diagnostic(module, t, "Identified here...", doir::diagnostic_type::Info) << std::endl;
+				auto [redeclaration, original] = order_declarations(module, res, t);
+				doir::print_diagnostic(module, redeclaration, (std::stringstream{} << "Function " << lexeme.view(module.buffer) << " redeclaired!").str()) << "\n";
+				doir::print_diagnostic(module, original, "Identified here...", doir::diagnostic_type::Info) << std::endl;
 				valid = false;
 			}
 		}
-		if(bool isParam = module.has_hashtable_attribute<lox::components::ParameterDeclaire>(t); module.has_hashtable_attribute<lox::components::VariableDeclaire>(t) || isParam) {
+		if(bool isParam = module.has_attribute<lox::components::ParameterDeclaire>(t); module.has_attribute<lox::components::VariableDeclaire>(t) || isParam) {
 			auto& lexeme = *module.get_attribute<doir::Lexeme>(t);
-			auto res = *blockwise_find<lox::comp::VariableDeclaire>(module, {lexeme, isParam ? current_function(module, t) + 1 : current_block(module, t)}, hasVariables);
+			auto res = *blockwise_find<lox::comp::VariableDeclaire>(module, variables, {lexeme, *module.get_attribute<doir::SymbolId>(t), isParam ? current_function(module, t) + 1 : current_block(module, t)});
 			if(res != t) {
-				doir::print_diagnostic(module, res, (std::stringstream{} << "Variable " << lexeme.view(module.buffer) << " redeclaired!").str()) << "\n";
-				doir::print_diagnostic(module, t, "Identified here...", doir::diagnostic_type::Info) << std::endl;
+				auto [redeclaration, original] = order_declarations(module, res, t);
+				doir::print_diagnostic(module, redeclaration, (std::stringstream{} << "Variable " << lexeme.view(module.buffer) << " redeclaired!").str()) << "\n";
+				doir::print_diagnostic(module, original, "Identified here...", doir::diagnostic_type::Info) << std::endl;
 				valid = false;
 			}
 		}
@@ -449,6 +450,136 @@ Identified here...
 	FrameMark;
 }
 
+TEST_CASE("Lox::Sema::DeclarationIndex") {
+	ZoneScopedN("Lox::Sema::DeclarationIndex");
+	using Variables = lox::comp::DeclarationIndex<lox::comp::VariableDeclaire>;
+	doir::ParseModule module("var a = 1; var b = 2; { var a = 3; var c = 4; } fun f(x) { var y = x; }");
+	auto root = lox::parse{}.start(module);
+	REQUIRE(root != 0);
+	auto a = *module.symbols.find("a"), b = *module.symbols.find("b");
+	auto& children = module.get_attribute<lox::comp::Block>(root)->children;
+	auto firstA = children[0], firstB = children[1];
+
+	// Exact lookups, and range scans over everything declared in a block
+	auto& variables = module.get_index<Variables>();
+	CHECK(variables.size() == 5);
+	CHECK(*variables.find_first({root, a}) == firstA);
+	CHECK(!variables.find_first({root, *module.symbols.find("c")}));
+	auto declared = variables.range({root, doir::SymbolId(0)}, {root + 1, doir::SymbolId(0)});
+	REQUIRE(declared.size() == 2);
+	CHECK(declared[0].token == firstA);
+	CHECK(declared[1].token == firstB);
+
+	// Every entry matches the attribute it was built from
+	auto consistent = [&](const Variables& index) {
+		for(auto& entry: index.all()) {
+			auto& key = *module.get_attribute<lox::comp::VariableDeclaire>(entry.token);
+			if(key.parent != entry.key.first || key.symbol != entry.key.second) return false;
+		}
+		return true;
+	};
+
+	// Removing, adding, and renumbering declarations is picked up the next time the index is requested
+	CHECK(module.remove_attribute<lox::comp::VariableDeclaire>(firstB));
+	CHECK(module.get_index<Variables>().size() == 4);
+	CHECK(!module.get_index<Variables>().find_first({root, b}));
+	auto t = module.make_token();
+	module.add_attribute<lox::comp::VariableDeclaire>(t) = {{0, 1}, b, root};
+	CHECK(*module.get_index<Variables>().find_first({root, b}) == t);
+	CHECK(consistent(module.get_index<Variables>()));
+
+	auto snapshot = module.take_snapshot();
+	canonicalize(module, root);
+	CHECK(module.get_index<Variables>().size() == 5);
+	CHECK(consistent(module.get_index<Variables>()));
+	module.restore(snapshot);
+	CHECK(*module.get_index<Variables>().find_first({root, b}) == t);
+	CHECK(consistent(module.get_index<Variables>()));
+
+	// Indices work over plain attributes in either storage mode
+	for(auto mode: {ecs::storage_mode::sparse_set, ecs::storage_mode::archetype}) {
+		doir::Module numbers("", mode);
+		for(double value: {3, 1, 2, 1})
+			numbers.add_attribute<double>(numbers.make_token()) = value;
+		using ByValue = doir::Index<double, decltype([](double d) { return d; })>;
+		auto& values = numbers.get_index<ByValue>();
+		CHECK(values.size() == 4);
+		CHECK(values.find(1).size() == 2);
+		CHECK(values.range(1.5, 3.5).size() == 2);
+		CHECK(values.all().front().key == 1);
+
+		// Appended values are merged into the middle of the index, shifting the runs after them
+		for(double value: {2, 0, 5})
+			numbers.add_attribute<double>(numbers.make_token()) = value;
+		auto& merged = numbers.get_index<ByValue>();
+		CHECK(merged.size() == 7);
+		for(double value: {0, 1, 2, 3, 5}) {
+			auto found = merged.find(value);
+			CHECK(found.size() == (value == 1 || value == 2 ? 2 : 1));
+			for(auto& entry: found)
+				CHECK(*numbers.get_attribute<double>(entry.token) == value);
+		}
+
+		// Swapping tokens moves their attributes to the other token, which the index notices (tokens 1 and 7 hold 3 and 5)
+		auto& scene = *(ecs::scene*)&numbers;
+		scene.swap_entities(1, 7);
+		CHECK(*numbers.get_index<ByValue>().find_first(3) == 7);
+		CHECK(*numbers.get_index<ByValue>().find_first(5) == 1);
+		std::pair<ecs::entity, ecs::entity> swaps[] = {{1, 7}, {2, 3}};
+		scene.swap_entities(swaps);
+		CHECK(*numbers.get_index<ByValue>().find_first(3) == 1);
+		CHECK(*numbers.get_index<ByValue>().find_first(2) == 2);
+		for(auto& entry: numbers.get_index<ByValue>().all())
+			CHECK(*numbers.get_attribute<double>(entry.token) == entry.key);
+	}
+	FrameMark;
+}
+
+TEST_CASE("Lox::Benchmark::ReorderEntities" * doctest::skip()) {
+	ZoneScopedN("Lox::Benchmark::ReorderEntities");
+	std::string source;
+	for(size_t i = 0; i < 25'000; ++i)
+		source += "fun f" + std::to_string(i) + "(a, b) { var c = a + b * " + std::to_string(i) + "; if(c > 10) print c; else c = c - 1; return f" + std::to_string(i) + "(c, b); } ";
+	doir::ParseModule module(source);
+	auto root = lox::parse{}.start(module);
+	REQUIRE(root != 0);
+	size_t size = module.token_count();
+	CHECK(size >= 1'000'000);
+
+	// Where in the source every block (and call) and the tokens it links to are, which renumbering mustn't change
+	auto links = [&module] {
+		std::vector<std::vector<size_t>> out;
+		for(auto [t, block]: doir::query_with_token<lox::comp::Block>(module)) {
+			auto& link = out.emplace_back(std::vector<size_t>{module.get_attribute<doir::Lexeme>(t)->start, module.get_attribute<doir::Lexeme>(block.parent)->start});
+			for(auto child: block.children) link.push_back(module.get_attribute<doir::Lexeme>(child)->start);
+		}
+		std::ranges::sort(out);
+		return out;
+	};
+	auto before = links();
+
+	// Reverse every token (besides the error token) then put them back in traversal order
+	std::vector<size_t> order(size);
+	std::iota(order.begin() + 1, order.end(), 1);
+	std::reverse(order.begin() + 1, order.end());
+	auto start = std::chrono::steady_clock::now();
+	{
+		ZoneScopedN("Lox::Benchmark::ReorderEntities::reverse");
+		((ecs::scene*)&module)->reorder_entities(order);
+	}
+	auto reversed = std::chrono::steady_clock::now();
+	{
+		ZoneScopedN("Lox::Benchmark::ReorderEntities::traversal");
+		sort_parse_into_reverse_post_order_traversal(module, size - root);
+	}
+	auto sorted = std::chrono::steady_clock::now();
+	CHECK(links() == before);
+	CHECK(calculate_child_count(module) + 2 <= size);
+	double reverseMs = std::chrono::duration<double, std::milli>(reversed - start).count(), sortMs = std::chrono::duration<double, std::milli>(sorted - reversed).count();
+	MESSAGE("Reordering " << size << " tokens: reversed in " << reverseMs << "ms, sorted into traversal order in " << sortMs << "ms");
+	FrameMark;
+}
+
 TEST_CASE("Lox::Sema" * doctest::skip()) {
 	doir::ParseModule module("fun add(a, b) { var tmp = a; a = b; b = tmp; return a + b; } var x = 0; var y = 1; if(true) print add(x, y); for(;;) print x;");
 	auto root = lox::parse{}.start(module);
@@ -1,4 +1,5 @@
 #include "../lox.hpp"
+#include <chrono>
 
 TEST_CASE("Lox::Benchmark::equality" * doctest::skip()) {
 	ZoneScopedN("Lox::Benchmark::equality");
@@ -23,4 +24,120 @@ TEST_CASE("Lox::Benchmark::equality" * doctest::skip()) {
 // )");
 // #endif
 	FrameMark;
-}
\ No newline at end of file
+}
+// Classifies tokens by probing each attribute in turn (how lox::token_type used to work) so dispatch costs can be compared
+static lox::Type token_type_by_probing(doir::Module& module, doir::Token t) {
+	ZoneScoped;
+	if(module.has_attribute<lox::comp::Variable>(t)) return lox::Type::Variable;
+	else if(module.has_attribute<lox::comp::Function>(t)) return lox::Type::Call;
+	else if(module.has_attribute<lox::comp::VariableDeclaire>(t)) return lox::Type::VariableDeclaire;
+	else if(module.has_attribute<lox::comp::FunctionDeclaire>(t)) return lox::Type::FunctionDeclaire;
+	else if(module.has_attribute<lox::comp::ParameterDeclaire>(t)) return lox::Type::ParameterDeclaire;
+	else if(module.has_attribute<lox::comp::BodyMarker>(t)) return lox::Type::BodyMarker;
+	else if(module.has_attribute<lox::comp::Not>(t)) return lox::Type::Not;
+	else if(module.has_attribute<lox::comp::Negate>(t)) return lox::Type::Negate;
+	else if(module.has_attribute<lox::comp::Divide>(t)) return lox::Type::Divide;
+	else if(module.has_attribute<lox::comp::Multiply>(t)) return lox::Type::Multiply;
+	else if(module.has_attribute<lox::comp::Add>(t)) return lox::Type::Add;
+	else if(module.has_attribute<lox::comp::Subtract>(t)) return lox::Type::Subtract;
+	else if(module.has_attribute<lox::comp::LessThan>(t)) return lox::Type::LessThan;
+	else if(module.has_attribute<lox::comp::LessThanEqualTo>(t)) return lox::Type::LessThanEqualTo;
+	else if(module.has_attribute<lox::comp::GreaterThan>(t)) return lox::Type::GreaterThan;
+	else if(module.has_attribute<lox::comp::GreaterThanEqualTo>(t)) return lox::Type::GreaterThanEqualTo;
+	else if(module.has_attribute<lox::comp::EqualTo>(t)) return lox::Type::EqualTo;
+	else if(module.has_attribute<lox::comp::NotEqualTo>(t)) return lox::Type::NotEqualTo;
+	else if(module.has_attribute<lox::comp::And>(t)) return lox::Type::And;
+	else if(module.has_attribute<lox::comp::Or>(t)) return lox::Type::Or;
+	else if(module.has_attribute<lox::comp::Assign>(t)) return lox::Type::Assign;
+	else if(module.has_attribute<lox::comp::Print>(t)) return lox::Type::Print;
+	else if(module.has_attribute<lox::comp::Return>(t)) return lox::Type::Return;
+	else if(module.has_attribute<lox::comp::While>(t)) return lox::Type::While;
+	else if(module.has_attribute<lox::comp::If>(t)) return lox::Type::If;
+	else if(module.has_attribute<lox::comp::Block>(t)) return lox::Type::Block;
+	else if(module.has_attribute<lox::comp::Null>(t)) return lox::Type::Null;
+	else if(module.has_attribute<lox::comp::String>(t)) return lox::Type::String;
+	else if(module.has_attribute<bool>(t)) return lox::Type::Boolean;
+	else if(module.has_attribute<double>(t)) return lox::Type::Number;
+	else return lox::Type::Invalid;
+}
+
+TEST_CASE("Lox::Benchmark::token_type" * doctest::skip()) {
+	ZoneScopedN("Lox::Benchmark::token_type");
+	constexpr size_t iterations = 1000;
+	for(std::string_view source: {
+#include "../../../../generated/benchmark/equality.lox.hpp"
+		,
+#include "../../../../generated/for/syntax.lox.hpp"
+		,
+#include "../../../../generated/operator/comparison.lox.hpp"
+	}) {
+		doir::ParseModule module{std::string(source)};
+		auto root = lox::parse{}.start(module);
+		REQUIRE(root != 0);
+		canonicalize(module, root, false);
+		REQUIRE(identify_trailing_calls(module));
+
+		size_t probed = 0, masked = 0;
+		{
+			ZoneScopedN("Lox::Benchmark::token_type::probing");
+			for(size_t i = 0; i < iterations; ++i)
+				for(doir::Token t = 0; t < module.token_count(); ++t)
+					probed += (size_t)token_type_by_probing(module, t);
+		}
+		{
+			ZoneScopedN("Lox::Benchmark::token_type::signature");
+			for(size_t i = 0; i < iterations; ++i)
+				for(doir::Token t = 0; t < module.token_count(); ++t)
+					masked += (size_t)lox::token_type(module, t);
+		}
+		CHECK(probed == masked);
+		for(doir::Token t = 0; t < module.token_count(); ++t)
+			CHECK(token_type_by_probing(module, t) == lox::token_type(module, t));
+	}
+	FrameMark;
+}
+
+TEST_CASE("Lox::Benchmark::compact" * doctest::skip()) {
+	ZoneScopedN("Lox::Benchmark::compact");
+	auto prepare = [](doir::ParseModule& module, bool compact) {
+		auto root = lox::parse{}.start(module);
+		REQUIRE(root != 0);
+		canonicalize(module, root, false);
+		REQUIRE(verify_references(module));
+		REQUIRE(verify_redeclarations(module));
+		REQUIRE(verify_call_arrities(module));
+		REQUIRE(identify_trailing_calls(module));
+		if(compact) {
+			ZoneScopedN("Lox::Benchmark::compact::compact");
+			module.compact();
+		}
+	};
+	auto time = [](doir::ParseModule& module) {
+		auto start = std::chrono::steady_clock::now();
+		REQUIRE(interpret(module));
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	for(std::string_view source: {
+#include "../../../../generated/benchmark/equality.lox.hpp"
+		,
+#include "../../../../generated/for/syntax.lox.hpp"
+		,
+#include "../../../../generated/operator/comparison.lox.hpp"
+	}) {
+		doir::ParseModule before{std::string(source)}, after{std::string(source)};
+		prepare(before, false);
+		prepare(after, true);
+		double beforeMs, afterMs;
+		{
+			ZoneScopedN("Lox::Benchmark::compact::before");
+			beforeMs = time(before);
+		}
+		{
+			ZoneScopedN("Lox::Benchmark::compact::after");
+			afterMs = time(after);
+		}
+		MESSAGE("interpret() took " << beforeMs << "ms before compacting and " << afterMs << "ms after");
+	}
+	FrameMark;
+}
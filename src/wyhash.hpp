@@ -0,0 +1,172 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+	#include <intrin.h>
+#endif
+
+// Word at a time hashing based on wyhash (final version 4, public domain: https://github.com/wangyi-fudan/wyhash)
+// NOTE: Provides the same interface as fnv::fnv1a_64 (specialize wyhash_64 for your key types) but consumes 8 bytes per multiply instead of 1
+namespace wyhash {
+	constexpr uint64_t secret[4] = {0x2d358dccaa6c78a5ull, 0x8bb84b93962eacc9ull, 0x4b33a62ed433d4a3ull, 0x4d5a2da51de1aa47ull};
+
+	namespace detail {
+		// 64x64 -> 128 bit multiply, the low half is returned in a and the high half in b
+		constexpr void mum(uint64_t& a, uint64_t& b) {
+#ifdef __SIZEOF_INT128__
+			__uint128_t r = a; r *= b;
+			a = uint64_t(r); b = uint64_t(r >> 64);
+#else
+	#if defined(_MSC_VER) && !defined(__clang__) && defined(_M_X64)
+			if(!std::is_constant_evaluated()) { a = _umul128(a, b, &b); return; }
+	#endif
+			uint64_t ha = a >> 32, hb = b >> 32, la = uint32_t(a), lb = uint32_t(b);
+			uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb, t = rl + (rm0 << 32), c = t < rl;
+			uint64_t lo = t + (rm1 << 32); c += lo < t;
+			a = lo; b = rh + (rm0 >> 32) + (rm1 >> 32) + c;
+#endif
+		}
+		constexpr uint64_t mix(uint64_t a, uint64_t b) { mum(a, b); return a ^ b; }
+
+		// Little endian reads which also work at compile time (where memcpy isn't allowed)
+		template<typename Tbyte>
+		constexpr uint64_t read(const Tbyte* p, size_t count) {
+			if(std::is_constant_evaluated() || std::endian::native != std::endian::little) {
+				uint64_t out = 0;
+				for(size_t i = 0; i < count; ++i)
+					out |= uint64_t(uint8_t(p[i])) << (8 * i);
+				return out;
+			}
+			uint64_t out = 0;
+			std::memcpy(&out, p, count);
+			return out;
+		}
+		template<typename Tbyte>
+		constexpr uint64_t read8(const Tbyte* p) { return read(p, 8); }
+		template<typename Tbyte>
+		constexpr uint64_t read4(const Tbyte* p) { return read(p, 4); }
+		template<typename Tbyte>
+		constexpr uint64_t read3(const Tbyte* p, size_t length) { return (uint64_t(uint8_t(p[0])) << 16) | (uint64_t(uint8_t(p[length >> 1])) << 8) | uint64_t(uint8_t(p[length - 1])); }
+	}
+
+	/**
+	* @brief Hashes a run of bytes
+	*
+	* @param p The bytes to hash (char, unsigned char, or std::byte)
+	* @param length The number of bytes
+	* @param seed Changes the hash function (useful for combining hashes or defending against crafted collisions)
+	* @note Usable at compile time, inputs longer than 48 bytes are consumed by three independent multiply chains so they can run in parallel
+	*/
+	template<typename Tbyte>
+	constexpr uint64_t hash_bytes(const Tbyte* p, size_t length, uint64_t seed = 0) {
+		static_assert(sizeof(Tbyte) == 1, "Only byte sized elements can be hashed");
+		seed ^= detail::mix(seed ^ secret[0], secret[1]);
+		uint64_t a, b;
+		if(length <= 16) {
+			if(length >= 4) {
+				size_t offset = (length >> 3) << 2; // 0 for lengths below 8, 4 otherwise
+				a = (detail::read4(p) << 32) | detail::read4(p + offset);
+				b = (detail::read4(p + length - 4) << 32) | detail::read4(p + length - 4 - offset);
+			} else if(length > 0) {
+				a = detail::read3(p, length);
+				b = 0;
+			} else a = b = 0;
+		} else {
+			size_t i = length;
+			if(i > 48) {
+				uint64_t see1 = seed, see2 = seed;
+				do {
+					seed = detail::mix(detail::read8(p) ^ secret[1], detail::read8(p + 8) ^ seed);
+					see1 = detail::mix(detail::read8(p + 16) ^ secret[2], detail::read8(p + 24) ^ see1);
+					see2 = detail::mix(detail::read8(p + 32) ^ secret[3], detail::read8(p + 40) ^ see2);
+					p += 48; i -= 48;
+				} while(i > 48);
+				seed ^= see1 ^ see2;
+			}
+			while(i > 16) {
+				seed = detail::mix(detail::read8(p) ^ secret[1], detail::read8(p + 8) ^ seed);
+				i -= 16; p += 16;
+			}
+			a = detail::read8(p + i - 16);
+			b = detail::read8(p + i - 8);
+		}
+		a ^= secret[1]; b ^= seed;
+		detail::mum(a, b);
+		return detail::mix(a ^ secret[0] ^ length, b ^ secret[1]);
+	}
+
+	/**
+	* @brief Hashes a single 64 bit value (cheaper than hashing its 8 bytes)
+	*/
+	constexpr uint64_t hash_integer(uint64_t value, uint64_t seed = 0) {
+		uint64_t a = value ^ secret[0], b = seed ^ secret[1];
+		detail::mum(a, b);
+		return detail::mix(a ^ secret[0], b ^ secret[1]);
+	}
+
+	/**
+	* @brief Merges two hashes into one (unlike xor, the order matters and equal hashes don't cancel out)
+	*/
+	constexpr uint64_t combine(uint64_t a, uint64_t b) { return detail::mix(a ^ secret[2], b ^ secret[3]); }
+
+	// Function object computing a 64-bit hash (values are hashed directly, other types by their object representation)
+	template<typename T>
+	struct wyhash_64 {
+		constexpr uint64_t operator()(const T& data) const {
+			if constexpr(std::is_enum_v<T>)
+				return hash_integer(uint64_t(std::to_underlying(data)));
+			else if constexpr(std::is_integral_v<T>)
+				return hash_integer(uint64_t(data));
+			else if constexpr(std::is_pointer_v<T>)
+				return hash_integer(uint64_t(std::bit_cast<uintptr_t>(data)));
+			else if constexpr(std::is_floating_point_v<T>)
+				return hash_bytes(std::bit_cast<std::array<std::byte, sizeof(T)>>(data == 0 ? T{} : data).data(), sizeof(T)); // -0.0 == 0.0
+			else {
+				// Padding bytes hold garbage, so types with padding need a specialization hashing their members
+				static_assert(std::has_unique_object_representations_v<T>, "wyhash_64 must be specialized for types with padding");
+				auto bytes = std::bit_cast<std::array<std::byte, sizeof(T)>>(data);
+				return hash_bytes(bytes.data(), bytes.size());
+			}
+		}
+	};
+	template<typename A, typename B>
+	struct wyhash_64<std::pair<A, B>> {
+		constexpr uint64_t operator()(const std::pair<A, B>& pair) const {
+			return combine(wyhash_64<A>{}(pair.first), wyhash_64<B>{}(pair.second));
+		}
+	};
+	template<>
+	struct wyhash_64<std::span<std::byte>> {
+		constexpr uint64_t operator()(std::span<std::byte> bytes) const {
+			return hash_bytes(bytes.data(), bytes.size());
+		}
+	};
+	template<>
+	struct wyhash_64<std::span<const std::byte>> {
+		constexpr uint64_t operator()(std::span<const std::byte> bytes) const {
+			return hash_bytes(bytes.data(), bytes.size());
+		}
+	};
+	template<>
+	struct wyhash_64<std::string> {
+		constexpr uint64_t operator()(const std::string& bytes) const {
+			return hash_bytes(bytes.data(), bytes.size());
+		}
+	};
+	template<>
+	struct wyhash_64<std::string_view> {
+		constexpr uint64_t operator()(std::string_view bytes) const {
+			return hash_bytes(bytes.data(), bytes.size());
+		}
+	};
+}